@@ -0,0 +1,91 @@
+#include "ChangeJournal.h"
+#include "Entity.h"
+#include "Transform.h"
+
+#include <algorithm>
+
+namespace primal::journal {
+
+	// anonymous namespace
+	namespace {
+		// NOTE: record i is stored at ring[i % ring.size()]. Sequence numbers don't wrap, so cursors stay valid forever.
+		utl::vector<change_record> ring;
+		u64 next_sequence{ 0 };
+		u32 frame{ 0 };
+
+		void append(change_type type, id::id_type entity, u32 flags) {
+			ring[next_sequence % ring.size()] = { frame, type, entity, flags };
+			++next_sequence;
+		}
+	} // anonymous namespace
+
+	void enable(u32 capacity) {
+		assert(capacity);
+		ring.clear();
+		ring.resize(capacity);
+		next_sequence = 0;
+		frame = 0;
+	}
+
+	void disable() {
+		ring.clear();
+		ring.shrink_to_fit();
+		next_sequence = 0;
+	}
+
+	bool is_enabled() {
+		return !ring.empty();
+	}
+
+	void end_frame() {
+		transform::clear_changes();
+	}
+
+	void record_created(game_entity::entity_id id) {
+		if (ring.empty()) return;
+		append(change_type::created, id, 0);
+	}
+
+	void record_removed(game_entity::entity_id id) {
+		if (ring.empty()) return;
+		append(change_type::removed, id, 0);
+	}
+
+	void record_transform_changes() {
+		if (ring.empty()) return;
+		for (const transform::transform_id id : transform::changes()) {
+			// NOTE: removed entities are already in the journal. New entities are also reported with all flags set.
+			const game_entity::entity_id entity{ (id::id_type)id };
+			if (!game_entity::is_alive(entity)) continue;
+			append(change_type::transform_changed, entity, transform::get_change_flags(id));
+		}
+		++frame;
+	}
+
+	void record_reset() {
+		if (ring.empty()) return;
+		append(change_type::reset, id::invalid_id, 0);
+	}
+
+	u64 begin_cursor() {
+		return next_sequence > ring.size() ? next_sequence - ring.size() : 0;
+	}
+
+	u64 end_cursor() {
+		return next_sequence;
+	}
+
+	u32 read(u64& cursor, change_record* const records, u32 max_count, bool& overrun) {
+		assert(records && cursor <= next_sequence);
+		overrun = cursor < begin_cursor();
+		if (overrun) cursor = begin_cursor();
+
+		const u32 count{ (u32)std::min<u64>(max_count, next_sequence - cursor) };
+		for (u32 i{ 0 }; i < count; ++i) {
+			records[i] = ring[(cursor + i) % ring.size()];
+		}
+
+		cursor += count;
+		return count;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include "ComponentsCommon.h"
+
+namespace primal::journal {
+
+	// The change journal records which entities were created or removed and which transforms changed,
+	// so that a reader (e.g. the editor) can pull the changes since its last read instead of querying
+	// every entity. Records are kept in a ring buffer, so the oldest ones are overwritten when readers fall behind.
+	// It's disabled by default, so the game doesn't pay for it.
+	enum class change_type : u32 {
+		created,
+		removed,
+		transform_changed,	// 'flags' holds the transform::change_flags
+		reset,				// the whole world was replaced, e.g. by restoring a snapshot. Readers should resynchronize.
+	};
+
+	struct change_record {
+		u32 frame;
+		change_type type;
+		id::id_type entity;
+		u32 flags;
+	};
+
+	// Starts recording into a ring of 'capacity' records. Enabling again clears the journal.
+	void enable(u32 capacity);
+	void disable();
+	[[nodiscard]] bool is_enabled();
+
+	// Transform changes are recorded when transform::clear_changes() is called, which also ends the frame.
+	// Records that are added after that get the next frame number.
+	// The game loop clears the changes after every simulation step. Readers that don't run the game loop
+	// have to call end_frame() themselves, which does the same.
+	void end_frame();
+
+	void record_created(game_entity::entity_id id);
+	void record_removed(game_entity::entity_id id);
+	void record_transform_changes();
+	void record_reset();
+
+	// Cursors are sequence numbers of records. end_cursor() is the cursor of the next record that will be added.
+	[[nodiscard]] u64 begin_cursor();
+	[[nodiscard]] u64 end_cursor();
+
+	// Copies at most 'max_count' records, starting at 'cursor', and moves the cursor past them. If records since
+	// the cursor were overwritten, 'overrun' is set, reading starts at the oldest record and readers should resynchronize.
+	u32 read(u64& cursor, change_record* const records, u32 max_count, bool& overrun);
+}
\ No newline at end of file
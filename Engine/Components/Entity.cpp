@@ -1,90 +1,499 @@
 #include "Entity.h"
 #include "Transform.h"
 #include "Script.h"
+#include "RigidBody.h"
+#include "Query.h"
+#include "Tags.h"
+#include "ChangeJournal.h"
+#include "..\Spatial\Spatial.h"
+
+#include <algorithm>
 
 namespace primal::game_entity {
 
 	// anonymous namespace
 	namespace {
-		utl::vector<transform::component> transforms;
-		utl::vector<script::component> scripts;
+		constexpr u32 chunk_size{ 16 * 1024 };
+		constexpr u32 transform_bit{ 1u << detail::transform_column };
+		constexpr u32 script_bit{ 1u << detail::script_column };
+		constexpr u32 rigid_body_bit{ 1u << detail::rigid_body_column };
+
+		constexpr u32 column_sizes[]{
+			sizeof(transform::component),
+			sizeof(script::component),
+			sizeof(rigid_body::component),
+		};
+		static_assert(_countof(column_sizes) == detail::column_count);
+
+		// Entities that have the same set of components share an archetype. An archetype stores its entities
+		// in fixed-size chunks. Each chunk has one tightly packed column for entity ids and one for each
+		// component in the set (SoA), so entities don't pay for components they don't have.
+		struct archetype {
+			u32 chunk_capacity{ 0 }; // number of entities per chunk. Zero means the archetype isn't used yet.
+			u32 column_offsets[detail::column_count]{};
+			u32 count{ 0 };
+			utl::vector<std::unique_ptr<u8[]>> chunks;
+		};
+
+		// NOTE: archetypes are indexed by their component mask. This is fine as long as the number of
+		//		 component types is small. Entities without a transform never use an archetype.
+		constexpr u32 archetype_count{ 1u << detail::column_count };
+		archetype archetypes[archetype_count];
 
+		struct entity_location {
+			u32 archetype{ u32_invalid_id };
+			u32 row{ u32_invalid_id };
+		};
+
+		utl::vector<entity_location> locations;
 		utl::vector<id::generation_type> generations;
 		utl::deque<entity_id> free_ids;
-	}
 
-	entity create(entity_info info) {
-		assert(info.transform); // all game entities must have a transform component
-		if (!info.transform) return entity{};
+		archetype& get_archetype(u32 mask) {
+			assert(mask < archetype_count && (mask & transform_bit));
+			archetype& a{ archetypes[mask] };
+			if (!a.chunk_capacity) {
+				u32 row_size{ sizeof(entity_id) };
+				for (u32 i{ 0 }; i < detail::column_count; ++i) {
+					if (mask & (1u << i)) row_size += column_sizes[i];
+				}
+
+				a.chunk_capacity = chunk_size / row_size;
+				u32 offset{ (u32)sizeof(entity_id) * a.chunk_capacity };
+				for (u32 i{ 0 }; i < detail::column_count; ++i) {
+					if (mask & (1u << i)) {
+						a.column_offsets[i] = offset;
+						offset += column_sizes[i] * a.chunk_capacity;
+					}
+					else {
+						a.column_offsets[i] = u32_invalid_id;
+					}
+				}
+				assert(offset <= chunk_size);
+			}
+
+			return a;
+		}
+
+		entity_id* id_at(archetype& a, u32 row) {
+			assert(row < a.count);
+			return (entity_id*)a.chunks[row / a.chunk_capacity].get() + (row % a.chunk_capacity);
+		}
+
+		u8* column_at(archetype& a, u32 row, u32 column) {
+			assert(row < a.count && a.column_offsets[column] != u32_invalid_id);
+			return a.chunks[row / a.chunk_capacity].get() + a.column_offsets[column] + (row % a.chunk_capacity) * column_sizes[column];
+		}
+
+		template<typename T> T& component_at(const entity_location& location) {
+			archetype& a{ archetypes[location.archetype] };
+			return *(T*)column_at(a, location.row, detail::column_of<T>::value);
+		}
+
+		// Appends a row for 'id' to the archetype of 'mask'. Component columns are initialized to invalid handles.
+		void add_row(u32 mask, entity_id id) {
+			archetype& a{ get_archetype(mask) };
+			const u32 row{ a.count };
+			if (row == a.chunks.size() * a.chunk_capacity) {
+				a.chunks.emplace_back(std::make_unique<u8[]>(chunk_size));
+			}
+
+			++a.count;
+			*id_at(a, row) = id;
+			if (mask & transform_bit) *(transform::component*)column_at(a, row, detail::transform_column) = {};
+			if (mask & script_bit) *(script::component*)column_at(a, row, detail::script_column) = {};
+			if (mask & rigid_body_bit) *(rigid_body::component*)column_at(a, row, detail::rigid_body_column) = {};
+			locations[id::index(id)] = { mask, row };
+		}
+
+		// Removes a row by moving the last row of the archetype into its place.
+		void remove_row(const entity_location& location) {
+			archetype& a{ archetypes[location.archetype] };
+			const u32 row{ location.row };
+			const u32 last_row{ a.count - 1 };
+
+			if (row != last_row) {
+				const entity_id last_id{ *id_at(a, last_row) };
+				*id_at(a, row) = last_id;
+				for (u32 i{ 0 }; i < detail::column_count; ++i) {
+					if (a.column_offsets[i] != u32_invalid_id) {
+						memcpy(column_at(a, row, i), column_at(a, last_row, i), column_sizes[i]);
+					}
+				}
+				locations[id::index(last_id)].row = row;
+			}
+
+			--a.count;
+
+			// NOTE: keep one empty chunk around, so that adding and removing entities
+			//		 at a chunk boundary doesn't allocate and free memory every time.
+			if (a.chunks.size() > 1 && a.count <= (a.chunks.size() - 2) * a.chunk_capacity) {
+				a.chunks.resize(a.chunks.size() - 1);
+			}
+		}
+
+		// Moves an entity to the archetype of 'new_mask' and copies the components both archetypes have.
+		void move_to_archetype(entity_id id, u32 new_mask) {
+			const entity_location old_location{ locations[id::index(id)] };
+			assert(old_location.archetype != new_mask);
+			add_row(new_mask, id);
 
-		entity_id id;
+			archetype& from{ archetypes[old_location.archetype] };
+			archetype& to{ archetypes[new_mask] };
+			const u32 new_row{ locations[id::index(id)].row };
+			const u32 common_mask{ old_location.archetype & new_mask };
+			for (u32 i{ 0 }; i < detail::column_count; ++i) {
+				if (common_mask & (1u << i)) {
+					memcpy(column_at(to, new_row, i), column_at(from, old_location.row, i), column_sizes[i]);
+				}
+			}
 
-		if (free_ids.size() > id::min_deleted_elements) {
-			id = free_ids.front();
-			assert(!is_alive(id));
-			free_ids.pop_front();
-			id = entity_id{ id::new_generation(id) };
-			++generations[id::index(id)];
+			remove_row(old_location);
 		}
-		else {
-			id = entity_id{ (id::id_type)generations.size() };
+
+		entity_id new_entity_id() {
+			// NOTE: an index whose generation can't be increased anymore is retired, so that
+			//		 ids of entities that were removed long ago don't become alive again.
+			while (free_ids.size() > id::min_deleted_elements) {
+				const entity_id id{ free_ids.front() };
+				assert(!is_alive(id));
+				free_ids.pop_front();
+				if (id::generation(id) + 1 >= id::detail::generation_mask) continue;
+
+				const entity_id new_id{ id::new_generation(id) };
+				++generations[id::index(new_id)];
+				return new_id;
+			}
+
+			const entity_id id{ (id::id_type)generations.size() };
 			generations.push_back(0);
 
-			// resize components
 			// NOTE: don't call resize(), so the number of memory allocations stays low
-			transforms.emplace_back();
-			scripts.emplace_back();
+			locations.emplace_back();
+
+			return id;
 		}
+	} // anonymous namespace
+
+	entity create(entity_info info) {
+		assert(info.transform); // all game entities must have a transform component
+		if (!info.transform) return entity{};
 
+		const entity_id id{ new_entity_id() };
 		const entity new_entity{ id };
 		const id::id_type index{ id::index(id) };
+		const bool has_script{ info.script && info.script->script_creator };
+		const bool has_rigid_body{ info.rigid_body != nullptr };
+
+		add_row(transform_bit | (has_script ? script_bit : 0) | (has_rigid_body ? rigid_body_bit : 0), id);
 
 		// create transform component
-		assert(!transforms[index].is_valid());
-		transforms[index] = transform::create(*info.transform, new_entity);
-		if (!transforms[index].is_valid()) return {};
+		transform::component& t{ component_at<transform::component>(locations[index]) };
+		t = transform::create(*info.transform, new_entity);
+		if (!t.is_valid()) {
+			remove_row(locations[index]);
+			locations[index] = {};
+			free_ids.push_back(id);
+			return {};
+		}
+
+		// create rigid body component
+		if (has_rigid_body) {
+			rigid_body::component r{ rigid_body::create(*info.rigid_body, new_entity) };
+			assert(r.is_valid());
+			component_at<rigid_body::component>(locations[index]) = r;
+		}
 
 		// create script component
-		if (info.script && info.script->script_creator) {
-			assert(!scripts[index].is_valid());
-			scripts[index] = script::create(*info.script, new_entity);
-			assert(scripts[index].is_valid());
+		if (has_script) {
+			script::component s{ script::create(*info.script, new_entity) };
+			assert(s.is_valid());
+			component_at<script::component>(locations[index]) = s;
 		}
 
+		journal::record_created(id);
 		return new_entity;
 	}
 
+	void create_many(entity_info info, const transform::init_info* const transforms, u32 count, entity_id* const ids) {
+		assert((transforms || info.transform) && ids);
+		if (!count) return;
+
+		const bool has_script{ info.script && info.script->script_creator };
+		const bool has_rigid_body{ info.rigid_body != nullptr };
+		const u32 mask{ transform_bit | (has_script ? script_bit : 0) | (has_rigid_body ? rigid_body_bit : 0) };
+
+		// NOTE: make room for all new entities first, so the arrays don't grow several times
+		archetype& a{ get_archetype(mask) };
+		while (a.chunks.size() * a.chunk_capacity < a.count + count) {
+			a.chunks.emplace_back(std::make_unique<u8[]>(chunk_size));
+		}
+		generations.reserve(generations.size() + count);
+		locations.reserve(locations.size() + count);
+
+		for (u32 i{ 0 }; i < count; ++i) {
+			ids[i] = new_entity_id();
+			add_row(mask, ids[i]);
+		}
+
+		// the transforms are created in one batch, because they're stored in one set of arrays
+		utl::vector<transform::init_info> transform_infos{};
+		if (!transforms) {
+			transform_infos.resize(count, *info.transform);
+		}
+
+		transform::create_many(transforms ? transforms : transform_infos.data(), ids, count);
+		for (u32 i{ 0 }; i < count; ++i) {
+			const entity_location& location{ locations[id::index(ids[i])] };
+			component_at<transform::component>(location) = transform::component{ transform::transform_id{ ids[i] } };
+			if (has_rigid_body) {
+				component_at<rigid_body::component>(location) = rigid_body::create(*info.rigid_body, entity{ ids[i] });
+			}
+			if (has_script) {
+				component_at<script::component>(location) = script::create(*info.script, entity{ ids[i] });
+			}
+			journal::record_created(ids[i]);
+		}
+	}
+
 	void remove(entity_id id) {
 		const id::id_type index{ id::index(id) };
 		assert(is_alive(id));
+		const entity_location location{ locations[index] };
+
+		if (location.archetype & script_bit) {
+			script::remove(component_at<script::component>(location));
+		}
 
-		if (scripts[index].is_valid()) {
-			script::remove(scripts[index]);
-			scripts[index] = {};
+		if (location.archetype & rigid_body_bit) {
+			rigid_body::remove(component_at<rigid_body::component>(location));
 		}
 
-		transform::remove(transforms[index]);
-		transforms[index] = {};
+		spatial::remove(id);
+		tags::remove(id);
+		journal::record_removed(id);
+		transform::remove(component_at<transform::component>(location));
+		remove_row(location);
+		locations[index] = {};
 		free_ids.push_back(id);
 	}
 
+	void remove_many(const entity_id* const ids, u32 count) {
+		assert(ids && count);
+		if (!ids || !count) return;
+
+		// NOTE: sort a copy of the ids by index, so that entity locations are visited front to back
+		utl::vector<entity_id> sorted_ids{};
+		sorted_ids.reserve(count);
+		for (u32 i{ 0 }; i < count; ++i) {
+			assert(is_alive(ids[i]));
+			sorted_ids.emplace_back(ids[i]);
+		}
+
+		std::sort(sorted_ids.begin(), sorted_ids.end(), [](entity_id a, entity_id b) {
+			return id::index(a) < id::index(b);
+			});
+
+		// remove script components in one batch
+		utl::vector<script::component> removed_scripts{};
+		for (const entity_id id : sorted_ids) {
+			const entity_location& location{ locations[id::index(id)] };
+			if (location.archetype & script_bit) {
+				removed_scripts.emplace_back(component_at<script::component>(location));
+			}
+		}
+
+		if (!removed_scripts.empty()) {
+			script::remove_many(removed_scripts.data(), (u32)removed_scripts.size());
+		}
+
+		// remove rigid body and transform components and free the rows
+		for (const entity_id id : sorted_ids) {
+			const id::id_type index{ id::index(id) };
+			if (locations[index].archetype & rigid_body_bit) {
+				rigid_body::remove(component_at<rigid_body::component>(locations[index]));
+			}
+
+			spatial::remove(id);
+			tags::remove(id);
+			journal::record_removed(id);
+			transform::remove(component_at<transform::component>(locations[index]));
+			remove_row(locations[index]);
+			locations[index] = {};
+		}
+
+		free_ids.insert(free_ids.end(), sorted_ids.begin(), sorted_ids.end());
+	}
+
+	script::component add_script(entity_id id, script::init_info info) {
+		assert(is_alive(id));
+		assert(info.script_creator);
+		const id::id_type index{ id::index(id) };
+		const u32 mask{ locations[index].archetype };
+		assert(!(mask & script_bit)); // entities can only have one script component
+		if ((mask & script_bit) || !info.script_creator) return {};
+
+		move_to_archetype(id, mask | script_bit);
+		script::component s{ script::create(info, entity{ id }) };
+		assert(s.is_valid());
+		component_at<script::component>(locations[index]) = s;
+
+		return s;
+	}
+
+	void remove_script(entity_id id) {
+		assert(is_alive(id));
+		const id::id_type index{ id::index(id) };
+		const u32 mask{ locations[index].archetype };
+		if (!(mask & script_bit)) return;
+
+		script::remove(component_at<script::component>(locations[index]));
+		move_to_archetype(id, mask & ~script_bit);
+	}
+
+	void get_ranges(u32 mask, u32 max_range_size, utl::vector<entity_range>& ranges) {
+		assert(mask && max_range_size);
+		for (u32 i{ 0 }; i < archetype_count; ++i) {
+			archetype& a{ archetypes[i] };
+			if ((i & mask) != mask || !a.count) continue;
+
+			for (u32 chunk_first{ 0 }; chunk_first < a.count; chunk_first += a.chunk_capacity) {
+				const u32 chunk_count{ std::min(a.chunk_capacity, a.count - chunk_first) };
+				u32 first{ 0 };
+				while (first < chunk_count) {
+					const u32 row{ chunk_first + first };
+					entity_range range{};
+					range.ids = id_at(a, row);
+					for (u32 c{ 0 }; c < detail::column_count; ++c) {
+						range.columns[c] = (i & (1u << c)) ? column_at(a, row, c) : nullptr;
+					}
+					range.count = std::min(max_range_size, chunk_count - first);
+					ranges.emplace_back(range);
+					first += range.count;
+				}
+			}
+		}
+	}
+
+	u64 snapshot_size() {
+		u64 size{ 3 * sizeof(u32) }; // chunk layout and number of archetypes
+		for (const archetype& a : archetypes) {
+			if (a.count) size += 3 * sizeof(u32) + a.chunks.size() * chunk_size;
+		}
+
+		return size + utl::vector_blob_size(generations) + utl::vector_blob_size(locations) +
+			sizeof(u32) + free_ids.size() * sizeof(entity_id);
+	}
+
+	void save_snapshot(utl::blob_stream_writer& writer) {
+		writer.write(chunk_size);
+		writer.write((u32)detail::column_count);
+
+		u32 archetypes_in_use{ 0 };
+		for (const archetype& a : archetypes) archetypes_in_use += a.count ? 1 : 0;
+		writer.write(archetypes_in_use);
+
+		for (u32 mask{ 0 }; mask < archetype_count; ++mask) {
+			const archetype& a{ archetypes[mask] };
+			if (!a.count) continue;
+			writer.write(mask);
+			writer.write(a.count);
+			// NOTE: the chunks are written whole, so restoring an archetype is one copy per chunk
+			writer.write((u32)a.chunks.size());
+			for (const auto& chunk : a.chunks) writer.write(chunk.get(), chunk_size);
+		}
+
+		writer.write_vector(generations);
+		writer.write_vector(locations);
+		writer.write((u32)free_ids.size());
+		for (const entity_id id : free_ids) writer.write((id::id_type)id);
+	}
+
+	bool validate_snapshot(const u8* const data, u64 size) {
+		utl::blob_stream_reader reader{ data };
+		// NOTE: the image may be damaged, so every step is checked against the size of the section
+		const auto has = [&](u64 bytes) { return reader.offset() + bytes <= size; };
+		const auto skip_vector = [&](u64 item_size, u32& count) {
+			if (!has(sizeof(u32))) return false;
+			count = reader.read<u32>();
+			if (!has(count * item_size)) return false;
+			reader.skip(count * item_size);
+			return true;
+		};
+
+		if (!has(3 * sizeof(u32))) return false;
+		if (reader.read<u32>() != chunk_size || reader.read<u32>() != (u32)detail::column_count) return false;
+
+		const u32 archetypes_in_use{ reader.read<u32>() };
+		for (u32 i{ 0 }; i < archetypes_in_use; ++i) {
+			if (!has(3 * sizeof(u32))) return false;
+			const u32 mask{ reader.read<u32>() };
+			const u32 count{ reader.read<u32>() };
+			const u32 chunk_count{ reader.read<u32>() };
+			if (mask >= archetype_count || !(mask & transform_bit) || count > (u64)chunk_count * chunk_size) return false;
+			if (!has((u64)chunk_count * chunk_size)) return false;
+			reader.skip((u64)chunk_count * chunk_size);
+		}
+
+		u32 generation_count, location_count, free_count;
+		if (!skip_vector(sizeof(id::generation_type), generation_count) || !skip_vector(sizeof(entity_location), location_count)) return false;
+		if (generation_count != location_count || !skip_vector(sizeof(id::id_type), free_count)) return false;
+		return reader.offset() == size;
+	}
+
+	bool restore_snapshot(utl::blob_stream_reader& reader) {
+		if (reader.read<u32>() != chunk_size || reader.read<u32>() != (u32)detail::column_count) return false;
+
+		for (archetype& a : archetypes) {
+			a.count = 0;
+			a.chunks.clear();
+		}
+
+		const u32 archetypes_in_use{ reader.read<u32>() };
+		for (u32 i{ 0 }; i < archetypes_in_use; ++i) {
+			archetype& a{ get_archetype(reader.read<u32>()) };
+			a.count = reader.read<u32>();
+			const u32 chunk_count{ reader.read<u32>() };
+			assert(a.count <= chunk_count * a.chunk_capacity);
+			for (u32 c{ 0 }; c < chunk_count; ++c) {
+				reader.read(a.chunks.emplace_back(std::make_unique<u8[]>(chunk_size)).get(), chunk_size);
+			}
+		}
+
+		reader.read_vector(generations);
+		reader.read_vector(locations);
+		assert(generations.size() == locations.size());
+		free_ids.clear();
+		const u32 free_count{ reader.read<u32>() };
+		for (u32 i{ 0 }; i < free_count; ++i) free_ids.emplace_back(reader.read<id::id_type>());
+
+		return true;
+	}
+
 	bool is_alive(entity_id id) {
 		assert(id::is_valid(id));
 		const id::id_type index{ id::index(id) };
-		assert(index < generations.size());
+		// NOTE: ids from before a snapshot was restored may be out of range
+		if (index >= generations.size()) return false;
 
-		return (generations[index] == id::generation(id) && transforms[index].is_valid());
+		return (generations[index] == id::generation(id) && locations[index].archetype != u32_invalid_id);
 	}
 
 	transform::component entity::transform() const {
 		assert(is_alive(_id));
 		const id::id_type index{ id::index(_id) };
-		return transforms[index];
+		return component_at<transform::component>(locations[index]);
 	}
 
 	script::component entity::script() const {
 		assert(is_alive(_id));
-		const id::id_type index{ id::index(_id) };
-		return scripts[index];
+		const entity_location& location{ locations[id::index(_id)] };
+		return (location.archetype & script_bit) ? component_at<script::component>(location) : script::component{};
+	}
+
+	rigid_body::component entity::rigid_body() const {
+		assert(is_alive(_id));
+		const entity_location& location{ locations[id::index(_id)] };
+		return (location.archetype & rigid_body_bit) ? component_at<rigid_body::component>(location) : rigid_body::component{};
 	}
 }
\ No newline at end of file
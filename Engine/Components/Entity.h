@@ -1,5 +1,6 @@
 #pragma once
 #include "ComponentsCommon.h"
+#include "..\Utilities\IOStream.h"
 
 
 namespace primal {
@@ -7,6 +8,7 @@ namespace primal {
 #define INIT_INFO(component) namespace component { struct init_info; }
 	INIT_INFO(transform);
 	INIT_INFO(script);
+	INIT_INFO(rigid_body);
 #undef INIT_INFO
 
 	namespace game_entity {
@@ -14,11 +16,27 @@ namespace primal {
 		{
 			transform::init_info* transform{ nullptr };
 			script::init_info* script{ nullptr };
+			rigid_body::init_info* rigid_body{ nullptr };
 		};
 
 		entity create(entity_info info);
+		// Creates 'count' entities with the same components and writes their ids to 'ids'. Entity i gets
+		// transforms[i], or info.transform if 'transforms' is nullptr. The components of all entities are created in bulk.
+		void create_many(entity_info info, const transform::init_info* const transforms, u32 count, entity_id* const ids);
 		void remove(entity_id id);
+		void remove_many(const entity_id* const ids, u32 count);
 		bool is_alive(entity_id id);
+
+		script::component add_script(entity_id id, script::init_info info);
+		void remove_script(entity_id id);
+
+		// Snapshots (see snapshot::save()). Archetype chunks are copied as they are.
+		[[nodiscard]] u64 snapshot_size();
+		void save_snapshot(utl::blob_stream_writer& writer);
+		// Checks the 'size' bytes of the entity section at 'data' without changing anything
+		[[nodiscard]] bool validate_snapshot(const u8* const data, u64 size);
+		// Returns false, without changing anything, if the snapshot has a different chunk layout
+		bool restore_snapshot(utl::blob_stream_reader& reader);
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "EntityCommands.h"
+#include "Entity.h"
+
+#include <algorithm>
+
+namespace primal::game_entity {
+
+	// anonymous namespace
+	namespace {
+		// NOTE: buffers are owned by this list and not by the threads that record into them,
+		//		 so commands recorded by a thread that has already exited are not lost.
+		utl::vector<std::unique_ptr<command_buffer>> thread_buffers;
+		std::mutex thread_buffers_mutex;
+
+		command_buffer* register_thread_buffer() {
+			std::lock_guard lock{ thread_buffers_mutex };
+			return thread_buffers.emplace_back(std::make_unique<command_buffer>()).get();
+		}
+
+		bool index_less(entity_id a, entity_id b) {
+			return id::index(a) < id::index(b);
+		}
+	}  // anonymous namespace
+
+	void command_buffer::create(transform::init_info transform_info, script::detail::script_creator script_creator) {
+		_creates.emplace_back(create_command{ transform_info, script_creator });
+	}
+
+	void command_buffer::remove(entity_id id) {
+		assert(id::is_valid(id));
+		_removes.emplace_back(id);
+	}
+
+	void command_buffer::add_script(entity_id id, script::detail::script_creator script_creator) {
+		assert(id::is_valid(id) && script_creator);
+		_add_scripts.emplace_back(add_script_command{ id, script_creator });
+	}
+
+	bool command_buffer::empty() const {
+		return _creates.empty() && _add_scripts.empty() && _removes.empty();
+	}
+
+	void command_buffer::clear() {
+		_creates.clear();
+		_add_scripts.clear();
+		_removes.clear();
+	}
+
+	command_buffer& commands() {
+		thread_local command_buffer* const buffer{ register_thread_buffer() };
+		return *buffer;
+	}
+
+	void flush_commands() {
+		utl::vector<command_buffer::create_command> creates{};
+		utl::vector<command_buffer::add_script_command> add_scripts{};
+		utl::vector<entity_id> removes{};
+
+		// NOTE: gather the commands and release the lock before applying them, because creating
+		//		 scripts may record new commands (and register new buffers) which will be applied next time.
+		{
+			std::lock_guard lock{ thread_buffers_mutex };
+			for (auto& buffer : thread_buffers) {
+				for (const auto& c : buffer->_creates) creates.emplace_back(c);
+				for (const auto& c : buffer->_add_scripts) add_scripts.emplace_back(c);
+				for (const entity_id id : buffer->_removes) removes.emplace_back(id);
+				buffer->clear();
+			}
+		}
+
+		for (auto& c : creates) {
+			script::init_info script_info{ c.script_creator };
+			entity_info info{ &c.transform, c.script_creator ? &script_info : nullptr };
+			[[maybe_unused]] const entity e{ game_entity::create(info) };
+			assert(e.is_valid());
+		}
+
+		// NOTE: the same entity may have been removed more than once (e.g. by different scripts),
+		//		 so sort the ids and skip duplicates and entities that are no longer alive.
+		std::sort(removes.begin(), removes.end(), index_less);
+		u32 remove_count{ 0 };
+		for (const entity_id id : removes) {
+			if ((remove_count && removes[remove_count - 1] == id) || !is_alive(id)) continue;
+			removes[remove_count++] = id;
+		}
+
+		std::sort(add_scripts.begin(), add_scripts.end(), [](const auto& a, const auto& b) { return index_less(a.id, b.id); });
+		for (const auto& c : add_scripts) {
+			if (!is_alive(c.id) || entity{ c.id }.script().is_valid() ||
+				std::binary_search(removes.begin(), removes.begin() + remove_count, c.id, index_less)) {
+				continue;
+			}
+
+			add_script(c.id, script::init_info{ c.script_creator });
+		}
+
+		if (remove_count) {
+			remove_many(removes.data(), remove_count);
+		}
+	}
+
+	void discard_commands() {
+		std::lock_guard lock{ thread_buffers_mutex };
+		for (auto& buffer : thread_buffers) buffer->clear();
+	}
+}
\ No newline at end of file
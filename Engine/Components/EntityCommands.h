@@ -0,0 +1,48 @@
+#pragma once
+#include "ComponentsCommon.h"
+#include "Transform.h"
+#include "Script.h"
+
+namespace primal::game_entity {
+
+	// Records structural changes (creating/removing entities and adding components), so they can be
+	// applied later at a sync point, instead of while component storage is being iterated
+	// (e.g. from inside entity_script::update()).
+	class command_buffer {
+	public:
+		void create(transform::init_info transform_info, script::detail::script_creator script_creator = nullptr);
+		void remove(entity_id id);
+		void add_script(entity_id id, script::detail::script_creator script_creator);
+
+		[[nodiscard]] bool empty() const;
+		void clear();
+
+	private:
+		friend void flush_commands();
+
+		struct create_command {
+			transform::init_info transform;
+			script::detail::script_creator script_creator;
+		};
+
+		struct add_script_command {
+			entity_id id;
+			script::detail::script_creator script_creator;
+		};
+
+		utl::vector<create_command> _creates;
+		utl::vector<add_script_command> _add_scripts;
+		utl::vector<entity_id> _removes;
+	};
+
+	// Returns the command buffer of the calling thread.
+	// NOTE: each thread records into its own buffer, so recording doesn't need any locks.
+	command_buffer& commands();
+
+	// Applies the recorded commands of all threads in one batch and clears the buffers.
+	// Entities are created first, then scripts are added and finally entities are removed.
+	// NOTE: call this at a sync point, when no other thread is recording commands.
+	void flush_commands();
+	// Drops the recorded commands of all threads, e.g. when the world is replaced by a snapshot
+	void discard_commands();
+}
\ No newline at end of file
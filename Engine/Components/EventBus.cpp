@@ -0,0 +1,180 @@
+#include "EventBus.h"
+#include "Entity.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+namespace primal::events {
+
+	// anonymous namespace
+	namespace {
+		// NOTE: event types are registered the first time they are used, which may be on any thread,
+		//		 so their data is kept in fixed-size arrays that don't move when a type is added.
+		constexpr u32 max_event_types{ 256 };
+		u32 event_sizes[max_event_types];
+		std::atomic<u32> event_type_count{ 0 };
+		std::mutex event_types_mutex;
+
+		struct subscriber {
+			detail::erased_handler func;
+			detail::invoker invoke;
+			void* context;
+		};
+
+		// the subscribers of each event type are stored next to each other
+		utl::vector<subscriber> subscribers[max_event_types];
+		DEBUG_OP(bool is_dispatching{ false });
+
+		struct event_record {
+			u32 type;
+			game_entity::entity_id recipient;
+			u32 offset;		// of the event in the data of its buffer
+		};
+
+		struct event_buffer {
+			utl::vector<event_record> records;
+			utl::vector<u8> data;
+		};
+
+		// NOTE: buffers are owned by this list and not by the threads that post into them,
+		//		 so events posted by a thread that has already exited are not lost.
+		utl::vector<std::unique_ptr<event_buffer>> thread_buffers;
+		std::mutex thread_buffers_mutex;
+
+		struct queued_event {
+			u32 type;
+			game_entity::entity_id recipient;
+			u32 buffer;
+			u32 offset;
+		};
+
+		// NOTE: the buffers are swapped with those of the threads when events are dispatched, and
+		//		 the vectors below are reused every frame, so posting doesn't allocate once they have grown.
+		utl::vector<event_buffer> dispatched_buffers;
+		utl::vector<queued_event> queued_events;
+		utl::vector<game_entity::entity_id> batch_recipients;
+		utl::vector<u8> batch_events;
+
+		event_buffer* register_thread_buffer() {
+			std::lock_guard lock{ thread_buffers_mutex };
+			return thread_buffers.emplace_back(std::make_unique<event_buffer>()).get();
+		}
+
+		event_buffer& thread_buffer() {
+			thread_local event_buffer* const buffer{ register_thread_buffer() };
+			return *buffer;
+		}
+
+		bool event_less(const queued_event& a, const queued_event& b) {
+			if (a.type != b.type) return a.type < b.type;
+			// NOTE: events without recipient come last
+			const id::id_type index_a{ id::is_valid(a.recipient) ? id::index(a.recipient) : id::invalid_id };
+			const id::id_type index_b{ id::is_valid(b.recipient) ? id::index(b.recipient) : id::invalid_id };
+			if (index_a != index_b) return index_a < index_b;
+			return a.buffer != b.buffer ? a.buffer < b.buffer : a.offset < b.offset;
+		}
+	} // anonymous namespace
+
+	namespace detail {
+		u32 register_event_type(u32 size, u32 alignment) {
+			// NOTE: batches of events are copied into a buffer from malloc(), which is aligned for any standard type
+			assert(alignment <= alignof(std::max_align_t));
+			std::lock_guard lock{ event_types_mutex };
+			const u32 type{ event_type_count.load() };
+			assert(type < max_event_types);
+			event_sizes[type] = size;
+			event_type_count.store(type + 1);
+			return type;
+		}
+
+		void post(u32 type, game_entity::entity_id recipient, const void* const event) {
+			assert(type < event_type_count.load(std::memory_order_relaxed) && event);
+			event_buffer& buffer{ thread_buffer() };
+			const u32 size{ event_sizes[type] };
+			const u32 offset{ (u32)buffer.data.size() };
+			// NOTE: resize() reserves exactly the new size, so grow the capacity like emplace_back() does
+			if (offset + size > buffer.data.capacity()) buffer.data.reserve(((offset + size) * 3) >> 1);
+			buffer.data.resize(offset + size);
+			memcpy(&buffer.data[offset], event, size);
+			buffer.records.emplace_back(event_record{ type, recipient, offset });
+		}
+
+		void subscribe(u32 type, erased_handler func, invoker invoke, void* context) {
+			assert(func && invoke);
+			DEBUG_OP(assert(!is_dispatching));
+			subscribers[type].emplace_back(subscriber{ func, invoke, context });
+		}
+
+		void unsubscribe(u32 type, erased_handler func, void* context) {
+			DEBUG_OP(assert(!is_dispatching));
+			utl::vector<subscriber>& list{ subscribers[type] };
+			for (u32 i{ 0 }; i < list.size(); ++i) {
+				if (list[i].func == func && list[i].context == context) {
+					list.erase(i);
+					return;
+				}
+			}
+		}
+	}
+
+	void dispatch() {
+		{
+			std::lock_guard lock{ thread_buffers_mutex };
+			while (dispatched_buffers.size() < thread_buffers.size()) dispatched_buffers.emplace_back();
+			for (u32 i{ 0 }; i < thread_buffers.size(); ++i) {
+				std::swap(dispatched_buffers[i].records, thread_buffers[i]->records);
+				std::swap(dispatched_buffers[i].data, thread_buffers[i]->data);
+			}
+		}
+
+		queued_events.clear();
+		for (u32 b{ 0 }; b < dispatched_buffers.size(); ++b) {
+			for (const event_record& r : dispatched_buffers[b].records) {
+				if (id::is_valid(r.recipient) && !game_entity::is_alive(r.recipient)) continue;
+				queued_events.emplace_back(queued_event{ r.type, r.recipient, b, r.offset });
+			}
+		}
+
+		std::sort(queued_events.begin(), queued_events.end(), event_less);
+
+		// deliver the events of each type in one batch
+		DEBUG_OP(is_dispatching = true);
+		const u32 event_count{ (u32)queued_events.size() };
+		for (u32 first{ 0 }, last{ 0 }; first < event_count; first = last) {
+			const u32 type{ queued_events[first].type };
+			while (last < event_count && queued_events[last].type == type) ++last;
+			if (subscribers[type].empty()) continue;
+
+			const u32 size{ event_sizes[type] };
+			const u32 count{ last - first };
+			batch_recipients.clear();
+			batch_recipients.reserve(count);
+			batch_events.resize(count * size);
+			for (u32 i{ 0 }; i < count; ++i) {
+				const queued_event& e{ queued_events[first + i] };
+				batch_recipients.emplace_back(e.recipient);
+				memcpy(&batch_events[i * size], &dispatched_buffers[e.buffer].data[e.offset], size);
+			}
+
+			for (const subscriber& s : subscribers[type]) {
+				s.invoke(s.func, batch_recipients.data(), batch_events.data(), count, s.context);
+			}
+		}
+		DEBUG_OP(is_dispatching = false);
+
+		for (event_buffer& buffer : dispatched_buffers) {
+			buffer.records.clear();
+			buffer.data.clear();
+		}
+	}
+
+	void discard() {
+		DEBUG_OP(assert(!is_dispatching));
+		std::lock_guard lock{ thread_buffers_mutex };
+		for (auto& buffer : thread_buffers) {
+			buffer->records.clear();
+			buffer->data.clear();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include "ComponentsCommon.h"
+#include "..\EngineAPI\EventBus.h"
+
+namespace primal::events {
+
+	// Delivers the events that were posted since the last call. Call it at a sync point,
+	// when no other thread is posting events. The engine calls it once per simulation step.
+	void dispatch();
+	// Drops the events that weren't delivered yet, e.g. when the world is replaced by a snapshot
+	void discard();
+}
\ No newline at end of file
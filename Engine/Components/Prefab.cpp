@@ -0,0 +1,45 @@
+#include "Prefab.h"
+#include "Transform.h"
+#include "Script.h"
+#include "RigidBody.h"
+
+namespace primal::prefab {
+
+	// anonymous namespace
+	namespace {
+		struct prefab_data {
+			transform::init_info transform{};
+			script::init_info script{};
+			rigid_body::init_info rigid_body{};
+			bool has_script{ false };
+			bool has_rigid_body{ false };
+		};
+
+		utl::free_list<prefab_data> prefabs;
+	} // anonymous namespace
+
+	id::id_type create(game_entity::entity_info info) {
+		assert(info.transform);
+		prefab_data data{};
+		data.transform = *info.transform;
+		data.has_script = info.script && info.script->script_creator;
+		if (data.has_script) data.script = *info.script;
+		data.has_rigid_body = info.rigid_body != nullptr;
+		if (data.has_rigid_body) data.rigid_body = *info.rigid_body;
+
+		return prefabs.add(data);
+	}
+
+	void remove(id::id_type id) {
+		prefabs.remove(id);
+	}
+
+	void instantiate(id::id_type id, const transform::init_info* const transforms, u32 count, game_entity::entity_id* const ids) {
+		prefab_data& data{ prefabs[id] };
+		game_entity::entity_info info{};
+		info.transform = &data.transform;
+		info.script = data.has_script ? &data.script : nullptr;
+		info.rigid_body = data.has_rigid_body ? &data.rigid_body : nullptr;
+		game_entity::create_many(info, transforms, count, ids);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+#include "ComponentsCommon.h"
+#include "Entity.h"
+
+namespace primal::prefab {
+
+	// A prefab stores the components of an entity once, so that many copies can be created in bulk,
+	// e.g. the trees of a forest or the agents of a crowd. Copies only differ in their transforms.
+	[[nodiscard]] id::id_type create(game_entity::entity_info info);
+	void remove(id::id_type id);
+
+	// Creates 'count' copies of a prefab and writes their ids to 'ids'. Copy i gets transforms[i],
+	// or the transform of the prefab if 'transforms' is nullptr.
+	void instantiate(id::id_type id, const transform::init_info* const transforms, u32 count, game_entity::entity_id* const ids);
+}
\ No newline at end of file
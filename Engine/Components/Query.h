@@ -0,0 +1,87 @@
+#pragma once
+#include "ComponentsCommon.h"
+
+namespace primal::game_entity {
+
+	namespace detail {
+		enum component_column : u32 {
+			transform_column,
+			script_column,
+			rigid_body_column,
+
+			column_count
+		};
+
+		template<typename T> struct column_of;
+		template<> struct column_of<transform::component> { static constexpr u32 value{ transform_column }; };
+		template<> struct column_of<script::component> { static constexpr u32 value{ script_column }; };
+		template<> struct column_of<rigid_body::component> { static constexpr u32 value{ rigid_body_column }; };
+
+		template<typename... T> constexpr u32 column_mask() {
+			return (0u | ... | (1u << column_of<T>::value));
+		}
+	}  // namespace detail
+
+	// A contiguous range of live entities that have (at least) the queried components.
+	// Columns are densely packed, so they can be walked without looking up or validating entity ids.
+	struct entity_range {
+		const entity_id* ids{ nullptr };
+		const void* columns[detail::column_count]{};
+		u32 count{ 0 };
+
+		template<typename T> [[nodiscard]] const T* column() const {
+			return static_cast<const T*>(columns[detail::column_of<T>::value]);
+		}
+	};
+
+	// Appends ranges of at most 'max_range_size' entities that have all components in 'mask' to 'ranges'.
+	// NOTE: ranges are invalidated by any call that creates or removes entities or components.
+	void get_ranges(u32 mask, u32 max_range_size, utl::vector<entity_range>& ranges);
+
+	// Calls 'func(entity, T...)' for every entity in 'range'
+	template<typename... T, typename F> void for_each(const entity_range& range, F&& func) {
+		const entity_id* const ids{ range.ids };
+		for (u32 i{ 0 }; i < range.count; ++i) {
+			func(entity{ ids[i] }, range.column<T>()[i]...);
+		}
+	}
+
+	// Calls 'func(entity, T...)' for every live entity that has all components T...
+	// Example: for_each<transform::component, script::component>([](entity e, transform::component t, script::component s) {...});
+	template<typename... T, typename F> void for_each(F&& func) {
+		static_assert(sizeof...(T) > 0, "At least one component type should be specified.");
+		utl::vector<entity_range> ranges{};
+		get_ranges(detail::column_mask<T...>(), u32_invalid_id, ranges);
+		for (const entity_range& range : ranges) {
+			for_each<T...>(range, func);
+		}
+	}
+
+	// Splits all live entities that have components T... into ranges of at most 'range_size' entities.
+	// Each range can be processed independently (e.g. by a different thread) using for_each(range, func).
+	template<typename... T> class query {
+	public:
+		static_assert(sizeof...(T) > 0, "At least one component type should be specified.");
+
+		explicit query(u32 range_size = 1024) {
+			assert(range_size);
+			get_ranges(detail::column_mask<T...>(), range_size, _ranges);
+		}
+
+		[[nodiscard]] u32 range_count() const { return (u32)_ranges.size(); }
+		[[nodiscard]] const entity_range& range(u32 index) const { return _ranges[index]; }
+
+		template<typename F> void for_each(u32 range_index, F&& func) const {
+			game_entity::for_each<T...>(_ranges[range_index], func);
+		}
+
+		template<typename F> void for_each(F&& func) const {
+			for (const entity_range& range : _ranges) {
+				game_entity::for_each<T...>(range, func);
+			}
+		}
+
+	private:
+		utl::vector<entity_range> _ranges;
+	};
+}
\ No newline at end of file
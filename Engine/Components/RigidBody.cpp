@@ -0,0 +1,531 @@
+#include "RigidBody.h"
+#include "Transform.h"
+#include "..\Spatial\SweepAndPrune.h"
+#include "..\Core\JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace primal::rigid_body {
+
+	// anonymous namespace
+	namespace {
+		// NOTE: body data is stored as SoA and indexed by body index, so the integrator can process 4 bodies
+		//		 per SIMD instruction. Bodies are kept dense by moving the last body into the place of a removed one.
+		utl::vector<f32> vx, vy, vz;			// velocity
+		utl::vector<f32> wx, wy, wz;			// angular velocity
+		utl::vector<f32> inv_mass;
+		utl::vector<f32> inv_inertia;
+		utl::vector<f32> gravity_scale;			// 1 for bodies with mass and 0 for static bodies
+		utl::vector<f32> radii;
+		utl::vector<f32> frictions;
+		utl::vector<f32> restitutions;
+		utl::vector<transform::transform_id> owners;
+		utl::vector<rigid_body_id> body_ids;
+		utl::vector<u32> proxies;
+		// per body data that is saved in snapshots as it is
+		utl::vector<f32>* const body_arrays[]{
+			&vx, &vy, &vz, &wx, &wy, &wz, &inv_mass, &inv_inertia, &gravity_scale, &radii, &frictions, &restitutions
+		};
+
+		utl::vector<u32> id_mapping;			// body index of each rigid body id
+		utl::vector<id::generation_type> generations;
+		utl::deque<rigid_body_id> free_ids;
+
+		world_settings settings{};
+		spatial::sweep_and_prune broadphase;
+
+		// scratch data for update()
+		utl::vector<f32> px, py, pz;
+		utl::vector<f32> qx, qy, qz, qw;
+		utl::vector<math::v3> pose_positions;
+		utl::vector<math::v4> pose_rotations;
+		utl::vector<transform::transform_id> moved_transforms;
+
+		struct contact {
+			u32 a;					// always a body with mass
+			u32 b;					// u32_invalid_id for the ground plane
+			math::v3 normal;		// from a to b
+			math::v3 tangent;		// direction of the sliding velocity, if any
+			f32 normal_mass;
+			f32 tangent_mass;
+			f32 bias;				// separating velocity that the solver aims for
+			f32 friction;
+			f32 normal_impulse;
+			f32 tangent_impulse;
+		};
+
+		utl::vector<contact> contacts;
+		utl::vector<contact> island_contacts;	// contacts sorted by island
+		utl::vector<u32> island_starts;
+		utl::vector<u32> parents;				// union-find forest of bodies
+		utl::vector<u32> island_of_root;
+		u32 last_island_count{ 0 };
+
+		constexpr f32 penetration_slop{ 0.005f };
+		constexpr f32 baumgarte{ 0.2f };
+		constexpr f32 restitution_threshold{ 1.f };
+		constexpr u32 island_range_size{ 4 };
+
+		bool exists(rigid_body_id id) {
+			assert(id::is_valid(id));
+			const id::id_type index{ id::index(id) };
+			return index < generations.size() && generations[index] == id::generation(id) &&
+				id_mapping[index] != u32_invalid_id;
+		}
+
+		u32 body_of(rigid_body_id id) {
+			assert(exists(id));
+			return id_mapping[id::index(id)];
+		}
+
+		DirectX::XMVECTOR load(const f32* const data, u32 count) {
+			if (count == 4) return DirectX::XMLoadFloat4((const DirectX::XMFLOAT4*)data);
+			f32 v[4]{};
+			memcpy(v, data, count * sizeof(f32));
+			return DirectX::XMLoadFloat4((const DirectX::XMFLOAT4*)v);
+		}
+
+		void store(f32* const data, DirectX::FXMVECTOR value, u32 count) {
+			if (count == 4) {
+				DirectX::XMStoreFloat4((DirectX::XMFLOAT4*)data, value);
+				return;
+			}
+			f32 v[4];
+			DirectX::XMStoreFloat4((DirectX::XMFLOAT4*)v, value);
+			memcpy(data, v, count * sizeof(f32));
+		}
+
+		math::v3 velocity_of(u32 body) { return { vx[body], vy[body], vz[body] }; }
+		math::v3 angular_velocity_of(u32 body) { return { wx[body], wy[body], wz[body] }; }
+
+		f32 dot(math::v3 a, math::v3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+		math::v3 cross(math::v3 a, math::v3 b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+		math::v3 scale(math::v3 a, f32 s) { return { a.x * s, a.y * s, a.z * s }; }
+		math::v3 add(math::v3 a, math::v3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+		math::v3 sub(math::v3 a, math::v3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+
+		void add_velocity(u32 body, math::v3 dv, math::v3 dw) {
+			vx[body] += dv.x; vy[body] += dv.y; vz[body] += dv.z;
+			wx[body] += dw.x; wy[body] += dw.y; wz[body] += dw.z;
+		}
+
+		// Velocity of b relative to a at the contact point
+		math::v3 relative_velocity(const contact& c) {
+			const math::v3 ra{ scale(c.normal, radii[c.a]) };
+			const math::v3 va{ add(velocity_of(c.a), cross(angular_velocity_of(c.a), ra)) };
+			if (c.b == u32_invalid_id) return scale(va, -1.f);
+
+			const math::v3 rb{ scale(c.normal, -radii[c.b]) };
+			const math::v3 vb{ add(velocity_of(c.b), cross(angular_velocity_of(c.b), rb)) };
+			return sub(vb, va);
+		}
+
+		void apply_impulse(const contact& c, math::v3 impulse) {
+			const math::v3 ra{ scale(c.normal, radii[c.a]) };
+			add_velocity(c.a, scale(impulse, -inv_mass[c.a]), scale(cross(ra, impulse), -inv_inertia[c.a]));
+
+			// NOTE: static bodies are shared by islands that are solved in parallel, so never write to them
+			if (c.b != u32_invalid_id && inv_mass[c.b] > 0.f) {
+				const math::v3 rb{ scale(c.normal, -radii[c.b]) };
+				add_velocity(c.b, scale(impulse, inv_mass[c.b]), scale(cross(rb, impulse), inv_inertia[c.b]));
+			}
+		}
+
+		void add_contact(u32 a, u32 b, math::v3 normal, f32 penetration, f32 dt) {
+			assert(inv_mass[a] > 0.f);
+			contact c{};
+			c.a = a;
+			c.b = b;
+			c.normal = normal;
+
+			const bool has_b{ b != u32_invalid_id };
+			const f32 inv_mass_b{ has_b ? inv_mass[b] : 0.f };
+			const f32 inv_inertia_b{ has_b ? inv_inertia[b] : 0.f };
+			const f32 radius_b{ has_b ? radii[b] : 0.f };
+			c.normal_mass = 1.f / (inv_mass[a] + inv_mass_b);
+			c.friction = std::sqrt(frictions[a] * (has_b ? frictions[b] : frictions[a]));
+
+			// NOTE: for spheres, the contact offsets are parallel to the normal and perpendicular to the tangent
+			const math::v3 v{ relative_velocity(c) };
+			const f32 vn{ dot(v, normal) };
+			const math::v3 vt{ sub(v, scale(normal, vn)) };
+			const f32 vt_length{ std::sqrt(dot(vt, vt)) };
+			if (vt_length > math::epsilon) {
+				c.tangent = scale(vt, 1.f / vt_length);
+				c.tangent_mass = 1.f / (inv_mass[a] + inv_mass_b +
+					inv_inertia[a] * radii[a] * radii[a] + inv_inertia_b * radius_b * radius_b);
+			}
+
+			// push overlapping bodies apart over a few frames and bounce bodies that hit each other fast enough
+			c.bias = baumgarte / dt * std::max(penetration - penetration_slop, 0.f);
+			const f32 restitution{ std::max(restitutions[a], has_b ? restitutions[b] : 0.f) };
+			if (vn < -restitution_threshold) c.bias = std::max(c.bias, -restitution * vn);
+
+			contacts.emplace_back(c);
+		}
+
+		void solve_contact(contact& c) {
+			// normal impulse: the bodies may only push each other apart
+			const f32 vn{ dot(relative_velocity(c), c.normal) };
+			const f32 old_normal_impulse{ c.normal_impulse };
+			c.normal_impulse = std::max(old_normal_impulse + c.normal_mass * (c.bias - vn), 0.f);
+			apply_impulse(c, scale(c.normal, c.normal_impulse - old_normal_impulse));
+
+			// friction impulse, limited by the normal impulse (Coulomb)
+			if (c.tangent_mass > 0.f) {
+				const f32 vt{ dot(relative_velocity(c), c.tangent) };
+				const f32 max_friction{ c.friction * c.normal_impulse };
+				const f32 old_tangent_impulse{ c.tangent_impulse };
+				c.tangent_impulse = std::clamp(old_tangent_impulse - c.tangent_mass * vt, -max_friction, max_friction);
+				apply_impulse(c, scale(c.tangent, c.tangent_impulse - old_tangent_impulse));
+			}
+		}
+
+		void gather_poses(u32 count) {
+			pose_positions.resize(count);
+			pose_rotations.resize(count);
+			transform::get_poses(owners.data(), pose_positions.data(), pose_rotations.data(), count);
+
+			px.resize(count); py.resize(count); pz.resize(count);
+			qx.resize(count); qy.resize(count); qz.resize(count); qw.resize(count);
+			for (u32 i{ 0 }; i < count; ++i) {
+				px[i] = pose_positions[i].x; py[i] = pose_positions[i].y; pz[i] = pose_positions[i].z;
+				qx[i] = pose_rotations[i].x; qy[i] = pose_rotations[i].y; qz[i] = pose_rotations[i].z; qw[i] = pose_rotations[i].w;
+			}
+		}
+
+		void integrate_velocities(u32 count, f32 dt) {
+			using namespace DirectX;
+			const XMVECTOR gx{ XMVectorReplicate(settings.gravity.x * dt) };
+			const XMVECTOR gy{ XMVectorReplicate(settings.gravity.y * dt) };
+			const XMVECTOR gz{ XMVectorReplicate(settings.gravity.z * dt) };
+			const XMVECTOR damping{ XMVectorReplicate(1.f / (1.f + dt * settings.linear_damping)) };
+
+			for (u32 i{ 0 }; i < count; i += 4) {
+				const u32 n{ std::min(4u, count - i) };
+				const XMVECTOR s{ load(&gravity_scale[i], n) };
+				store(&vx[i], XMVectorMultiply(XMVectorMultiplyAdd(s, gx, load(&vx[i], n)), damping), n);
+				store(&vy[i], XMVectorMultiply(XMVectorMultiplyAdd(s, gy, load(&vy[i], n)), damping), n);
+				store(&vz[i], XMVectorMultiply(XMVectorMultiplyAdd(s, gz, load(&vz[i], n)), damping), n);
+			}
+		}
+
+		void find_contacts(u32 count, f32 dt) {
+			contacts.clear();
+			for (u32 i{ 0 }; i < count; ++i) {
+				const f32 r{ radii[i] };
+				broadphase.move(proxies[i], { { px[i] - r, py[i] - r, pz[i] - r }, { px[i] + r, py[i] + r, pz[i] + r } });
+			}
+			broadphase.update();
+
+			for (const u64 pair : broadphase.pairs()) {
+				u32 a{ body_of(rigid_body_id{ (id::id_type)(pair >> 32) }) };
+				u32 b{ body_of(rigid_body_id{ (id::id_type)pair }) };
+				if (inv_mass[a] == 0.f && inv_mass[b] == 0.f) continue;
+				if (inv_mass[a] == 0.f) std::swap(a, b);
+
+				const math::v3 d{ px[b] - px[a], py[b] - py[a], pz[b] - pz[a] };
+				const f32 distance_sq{ dot(d, d) };
+				const f32 radius_sum{ radii[a] + radii[b] };
+				if (distance_sq >= radius_sum * radius_sum) continue;
+
+				const f32 distance{ std::sqrt(distance_sq) };
+				const math::v3 normal{ distance > math::epsilon ? scale(d, 1.f / distance) : math::v3{ 0.f, 1.f, 0.f } };
+				add_contact(a, b, normal, radius_sum - distance, dt);
+			}
+
+			if (settings.ground_plane) {
+				for (u32 i{ 0 }; i < count; ++i) {
+					const f32 penetration{ settings.ground_height - (py[i] - radii[i]) };
+					if (inv_mass[i] > 0.f && penetration > 0.f) {
+						add_contact(i, u32_invalid_id, { 0.f, -1.f, 0.f }, penetration, dt);
+					}
+				}
+			}
+		}
+
+		u32 find_root(u32 body) {
+			while (parents[body] != body) {
+				parents[body] = parents[parents[body]];
+				body = parents[body];
+			}
+			return body;
+		}
+
+		// Groups the contacts by island. Bodies with mass that touch each other (directly or through other bodies
+		// with mass) are in the same island. Static bodies don't connect islands, because they never move.
+		u32 build_islands(u32 count) {
+			parents.resize(count);
+			for (u32 i{ 0 }; i < count; ++i) parents[i] = i;
+			for (const contact& c : contacts) {
+				if (c.b == u32_invalid_id || inv_mass[c.b] == 0.f) continue;
+				const u32 ra{ find_root(c.a) }, rb{ find_root(c.b) };
+				if (ra != rb) parents[ra] = rb;
+			}
+
+			// number the islands and count their contacts
+			island_of_root.resize(count);
+			memset(island_of_root.data(), 0xff, count * sizeof(u32));
+			island_starts.clear();
+			for (const contact& c : contacts) {
+				u32& island{ island_of_root[find_root(c.a)] };
+				if (island == u32_invalid_id) {
+					island = (u32)island_starts.size();
+					island_starts.emplace_back(0);
+				}
+				++island_starts[island];
+			}
+
+			const u32 island_count{ (u32)island_starts.size() };
+			u32 sum{ 0 };
+			for (u32& start : island_starts) {
+				const u32 c{ start };
+				start = sum;
+				sum += c;
+			}
+			island_starts.emplace_back(sum);
+
+			// counting sort of the contacts by island
+			island_contacts.resize(contacts.size());
+			utl::vector<u32> cursors{};
+			cursors.resize(island_count);
+			memcpy(cursors.data(), island_starts.data(), island_count * sizeof(u32));
+			for (const contact& c : contacts) {
+				island_contacts[cursors[island_of_root[find_root(c.a)]]++] = c;
+			}
+
+			return island_count;
+		}
+
+		void integrate_poses(u32 count, f32 dt) {
+			using namespace DirectX;
+			const XMVECTOR step{ XMVectorReplicate(dt) };
+			const XMVECTOR half_step{ XMVectorReplicate(0.5f * dt) };
+
+			for (u32 i{ 0 }; i < count; i += 4) {
+				const u32 n{ std::min(4u, count - i) };
+				const XMVECTOR vx4{ load(&vx[i], n) }, vy4{ load(&vy[i], n) }, vz4{ load(&vz[i], n) };
+				store(&px[i], XMVectorMultiplyAdd(vx4, step, load(&px[i], n)), n);
+				store(&py[i], XMVectorMultiplyAdd(vy4, step, load(&py[i], n)), n);
+				store(&pz[i], XMVectorMultiplyAdd(vz4, step, load(&pz[i], n)), n);
+
+				// q += dt / 2 * (w, 0) * q, then normalize
+				const XMVECTOR wx4{ load(&wx[i], n) }, wy4{ load(&wy[i], n) }, wz4{ load(&wz[i], n) };
+				XMVECTOR x{ load(&qx[i], n) }, y{ load(&qy[i], n) }, z{ load(&qz[i], n) }, w{ load(&qw[i], n) };
+				const XMVECTOR dx{ XMVectorSubtract(XMVectorAdd(XMVectorMultiply(wx4, w), XMVectorMultiply(wy4, z)), XMVectorMultiply(wz4, y)) };
+				const XMVECTOR dy{ XMVectorSubtract(XMVectorAdd(XMVectorMultiply(wy4, w), XMVectorMultiply(wz4, x)), XMVectorMultiply(wx4, z)) };
+				const XMVECTOR dz{ XMVectorSubtract(XMVectorAdd(XMVectorMultiply(wz4, w), XMVectorMultiply(wx4, y)), XMVectorMultiply(wy4, x)) };
+				const XMVECTOR dw{ XMVectorAdd(XMVectorAdd(XMVectorMultiply(wx4, x), XMVectorMultiply(wy4, y)), XMVectorMultiply(wz4, z)) };
+				x = XMVectorMultiplyAdd(dx, half_step, x);
+				y = XMVectorMultiplyAdd(dy, half_step, y);
+				z = XMVectorMultiplyAdd(dz, half_step, z);
+				w = XMVectorNegativeMultiplySubtract(dw, half_step, w);
+
+				const XMVECTOR length_sq{ XMVectorAdd(XMVectorAdd(XMVectorMultiply(x, x), XMVectorMultiply(y, y)),
+					XMVectorAdd(XMVectorMultiply(z, z), XMVectorMultiply(w, w))) };
+				const XMVECTOR inv_length{ XMVectorReciprocal(XMVectorSqrt(length_sq)) };
+				store(&qx[i], XMVectorMultiply(x, inv_length), n);
+				store(&qy[i], XMVectorMultiply(y, inv_length), n);
+				store(&qz[i], XMVectorMultiply(z, inv_length), n);
+				store(&qw[i], XMVectorMultiply(w, inv_length), n);
+			}
+		}
+
+		void write_poses(u32 count) {
+			moved_transforms.clear();
+			u32 moved{ 0 };
+			for (u32 i{ 0 }; i < count; ++i) {
+				// NOTE: don't touch the transforms of bodies that don't move, so they don't show up as changed
+				if (vx[i] == 0.f && vy[i] == 0.f && vz[i] == 0.f && wx[i] == 0.f && wy[i] == 0.f && wz[i] == 0.f) continue;
+				moved_transforms.emplace_back(owners[i]);
+				pose_positions[moved] = { px[i], py[i], pz[i] };
+				pose_rotations[moved] = { qx[i], qy[i], qz[i], qw[i] };
+				++moved;
+			}
+
+			if (moved) transform::set_poses(moved_transforms.data(), pose_positions.data(), pose_rotations.data(), moved);
+		}
+	} // anonymous namespace
+
+	component create(init_info info, game_entity::entity entity) {
+		assert(entity.is_valid());
+		assert(info.mass >= 0.f && info.radius > 0.f);
+
+		rigid_body_id id{};
+		if (free_ids.size() > id::min_deleted_elements) {
+			id = free_ids.front();
+			assert(!exists(id));
+			free_ids.pop_front();
+			id = rigid_body_id{ id::new_generation(id) };
+			++generations[id::index(id)];
+		}
+		else {
+			id = rigid_body_id{ (id::id_type)id_mapping.size() };
+			id_mapping.emplace_back();
+			generations.push_back(0);
+		}
+
+		const u32 body{ (u32)body_ids.size() };
+		id_mapping[id::index(id)] = body;
+
+		const f32 mass_inverse{ info.mass > 0.f ? 1.f / info.mass : 0.f };
+		vx.emplace_back(info.velocity[0]); vy.emplace_back(info.velocity[1]); vz.emplace_back(info.velocity[2]);
+		wx.emplace_back(info.angular_velocity[0]); wy.emplace_back(info.angular_velocity[1]); wz.emplace_back(info.angular_velocity[2]);
+		inv_mass.emplace_back(mass_inverse);
+		// solid sphere: I = 2/5 m r^2
+		inv_inertia.emplace_back(mass_inverse * 2.5f / (info.radius * info.radius));
+		gravity_scale.emplace_back(info.mass > 0.f ? 1.f : 0.f);
+		radii.emplace_back(info.radius);
+		frictions.emplace_back(info.friction);
+		restitutions.emplace_back(info.restitution);
+		owners.emplace_back(entity.get_id());
+		body_ids.emplace_back(id);
+
+		const math::v3 p{ entity.transform().position() };
+		const f32 r{ info.radius };
+		proxies.emplace_back(broadphase.add({ { p.x - r, p.y - r, p.z - r }, { p.x + r, p.y + r, p.z + r } }, (u32)id));
+
+		return component{ id };
+	}
+
+	void remove(component c) {
+		assert(c.is_valid() && exists(c.get_id()));
+		const u32 body{ body_of(c.get_id()) };
+		const rigid_body_id last_id{ body_ids.back() };
+
+		broadphase.remove(proxies[body]);
+		utl::erase_unordered(vx, body); utl::erase_unordered(vy, body); utl::erase_unordered(vz, body);
+		utl::erase_unordered(wx, body); utl::erase_unordered(wy, body); utl::erase_unordered(wz, body);
+		utl::erase_unordered(inv_mass, body);
+		utl::erase_unordered(inv_inertia, body);
+		utl::erase_unordered(gravity_scale, body);
+		utl::erase_unordered(radii, body);
+		utl::erase_unordered(frictions, body);
+		utl::erase_unordered(restitutions, body);
+		utl::erase_unordered(owners, body);
+		utl::erase_unordered(body_ids, body);
+		utl::erase_unordered(proxies, body);
+
+		id_mapping[id::index(last_id)] = body;
+		id_mapping[id::index(c.get_id())] = u32_invalid_id;
+		free_ids.push_back(c.get_id());
+	}
+
+	void set_world_settings(const world_settings& new_settings) {
+		assert(new_settings.solver_iterations);
+		settings = new_settings;
+	}
+
+	const world_settings& get_world_settings() {
+		return settings;
+	}
+
+	void update(f32 dt) {
+		const u32 body_count{ count() };
+		if (!body_count || dt <= 0.f) return;
+
+		gather_poses(body_count);
+		integrate_velocities(body_count, dt);
+		find_contacts(body_count, dt);
+
+		last_island_count = build_islands(body_count);
+		contact* const sorted{ island_contacts.data() };
+		const u32* const starts{ island_starts.data() };
+		const u32 iterations{ settings.solver_iterations };
+		jobs::parallel_for(last_island_count, island_range_size, [sorted, starts, iterations](u32 first, u32 last) {
+			for (u32 island{ first }; island < last; ++island) {
+				for (u32 it{ 0 }; it < iterations; ++it) {
+					for (u32 i{ starts[island] }; i < starts[island + 1]; ++i) {
+						solve_contact(sorted[i]);
+					}
+				}
+			}
+			});
+
+		integrate_poses(body_count, dt);
+		write_poses(body_count);
+	}
+
+	u32 count() {
+		return (u32)body_ids.size();
+	}
+
+	u32 island_count() {
+		return last_island_count;
+	}
+
+	u64 snapshot_size() {
+		u64 size{ sizeof(world_settings) + utl::vector_blob_size(id_mapping) + utl::vector_blob_size(generations) +
+			sizeof(u32) + free_ids.size() * sizeof(rigid_body_id) };
+		for (const utl::vector<f32>* const v : body_arrays) {
+			size += utl::vector_blob_size(*v);
+		}
+
+		return size + utl::vector_blob_size(owners) + utl::vector_blob_size(body_ids);
+	}
+
+	void save_snapshot(utl::blob_stream_writer& writer) {
+		writer.write((const u8*)&settings, sizeof(world_settings));
+		for (const utl::vector<f32>* const v : body_arrays) {
+			writer.write_vector(*v);
+		}
+
+		writer.write_vector(owners);
+		writer.write_vector(body_ids);
+		writer.write_vector(id_mapping);
+		writer.write_vector(generations);
+		writer.write((u32)free_ids.size());
+		for (const rigid_body_id id : free_ids) writer.write((id::id_type)id);
+	}
+
+	void restore_snapshot(utl::blob_stream_reader& reader) {
+		reader.read((u8*)&settings, sizeof(world_settings));
+		for (utl::vector<f32>* const v : body_arrays) {
+			reader.read_vector(*v);
+		}
+
+		reader.read_vector(owners);
+		reader.read_vector(body_ids);
+		reader.read_vector(id_mapping);
+		reader.read_vector(generations);
+		free_ids.clear();
+		const u32 free_count{ reader.read<u32>() };
+		for (u32 i{ 0 }; i < free_count; ++i) free_ids.emplace_back(reader.read<id::id_type>());
+
+		// NOTE: the broadphase only holds derived data, so it's rebuilt instead of saved
+		broadphase.clear();
+		const u32 body_count{ count() };
+		proxies.resize(body_count);
+		for (u32 i{ 0 }; i < body_count; ++i) {
+			const math::v3 p{ game_entity::entity{ game_entity::entity_id{ (id::id_type)owners[i] } }.transform().position() };
+			const f32 r{ radii[i] };
+			proxies[i] = broadphase.add({ { p.x - r, p.y - r, p.z - r }, { p.x + r, p.y + r, p.z + r } }, (u32)body_ids[i]);
+		}
+
+		last_island_count = 0;
+	}
+
+	math::v3 component::velocity() const {
+		return velocity_of(body_of(_id));
+	}
+
+	math::v3 component::angular_velocity() const {
+		return angular_velocity_of(body_of(_id));
+	}
+
+	void component::set_velocity(math::v3 velocity) {
+		const u32 body{ body_of(_id) };
+		vx[body] = velocity.x; vy[body] = velocity.y; vz[body] = velocity.z;
+	}
+
+	void component::set_angular_velocity(math::v3 angular_velocity) {
+		const u32 body{ body_of(_id) };
+		wx[body] = angular_velocity.x; wy[body] = angular_velocity.y; wz[body] = angular_velocity.z;
+	}
+
+	void component::apply_impulse(math::v3 impulse) {
+		const u32 body{ body_of(_id) };
+		add_velocity(body, scale(impulse, inv_mass[body]), {});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "ComponentsCommon.h"
+#include "..\Utilities\IOStream.h"
+
+namespace primal::rigid_body {
+
+	// Bodies are solid spheres. A body without mass is static: it collides, but gravity and impulses don't move it.
+	struct init_info
+	{
+		f32 mass{ 1.f };
+		f32 radius{ 0.5f };
+		f32 friction{ 0.5f };
+		f32 restitution{ 0.f };
+		f32 velocity[3]{};
+		f32 angular_velocity[3]{};
+	};
+
+	struct world_settings
+	{
+		math::v3 gravity{ 0.f, -9.81f, 0.f };
+		f32 linear_damping{ 0.f };
+		u32 solver_iterations{ 8 };
+		// Infinite static plane at y = ground_height that bodies rest on
+		bool ground_plane{ false };
+		f32 ground_height{ 0.f };
+	};
+
+	component create(init_info info, game_entity::entity entity);
+	void remove(component c);
+
+	void set_world_settings(const world_settings& settings);
+	[[nodiscard]] const world_settings& get_world_settings();
+
+	// Advances the simulation by dt seconds and writes the new positions and rotations to the transforms
+	// of the bodies that moved. Bodies that touch each other form islands, which are solved in parallel.
+	void update(f32 dt);
+
+	[[nodiscard]] u32 count();
+	[[nodiscard]] u32 island_count();	// number of islands with contacts in the last update
+
+	// Snapshots (see snapshot::save()). Transforms must be restored first.
+	[[nodiscard]] u64 snapshot_size();
+	void save_snapshot(utl::blob_stream_writer& writer);
+	void restore_snapshot(utl::blob_stream_reader& reader);
+}
\ No newline at end of file
@@ -1,15 +1,96 @@
 #include "Script.h"
 
 #include "Entity.h"
+#include "..\Core\JobSystem.h"
+#include "..\Core\Scheduler.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace primal::script {
 	namespace {
-		utl::vector<detail::script_ptr> entity_scripts;
-		utl::vector<id::id_type> id_mapping;
+		struct tick_state {
+			f32 accumulated_dt{ 0.f };
+			u32 phase{ 0 };
+			u32 base_interval{ 1 };
+			u32 interval{ 1 };		// base_interval multiplied by the update LOD
+		};
+
+		// Scripts are stored in per-type pools. For every pool that is in use we keep the ids
+		// of its scripts, in the same order as the scripts in the pool.
+		// NOTE: the first active_count scripts of a pool are awake and the rest are sleeping,
+		//		 so update() never touches sleeping scripts.
+		struct pool_entry {
+			detail::script_pool_base* pool;
+			utl::vector<script_id> ids;
+			utl::vector<tick_state> ticks;
+			u32 active_count{ 0 };
+			u32 next_phase{ 0 };
+			// NOTE: pools where every script ticks every frame skip the tick bookkeeping
+			bool uses_ticks{ false };
+		};
+
+		struct script_location {
+			u32 pool{ u32_invalid_id };
+			u32 index{ u32_invalid_id };
+		};
+
+		utl::vector<pool_entry> pools;
+		std::unordered_map<detail::script_pool_base*, u32> pool_indices;
+		utl::vector<script_location> id_mapping;
+		// NOTE: incremented whenever a script goes to sleep or wakes up, so that timers
+		//		 that were started before can be recognized as stale.
+		utl::vector<u32> sleep_serials;
 
 		utl::vector<id::generation_type> generations;
 		utl::deque<script_id> free_ids;
 
+		// NOTE: scripts can't be created or removed while they're being updated, because that
+		//		 would change the script pools while iterating them. Use game_entity::commands() instead.
+		DEBUG_OP(bool is_updating{ false });
+
+		constexpr u32 parallel_update_range_size{ 256 };
+		bool parallel_update{ false };
+
+		update_lod_func update_lod{ nullptr };
+		u32 frame{ 0 };
+		utl::vector<u32> due_indices;
+		utl::vector<f32> due_dts;
+
+		// Low priority scripts are updated by a scheduler task that walks over all low priority pools,
+		// a few scripts per slice. A new pass starts after the previous one is finished.
+		constexpr u32 low_priority_slice_size{ 64 };
+		u32 low_priority_pool{ 0 };
+		u32 low_priority_index{ 0 };
+		bool low_priority_pass_pending{ false };
+
+		// Sleep and wake requests can come from any thread (e.g. from scripts that are updated in parallel).
+		// They are applied at the start of the next update, in the order they were made, so the last one wins.
+		struct sleep_request {
+			script_id id;
+			f32 time;		// negative for wake requests and for sleeping until woken
+			bool wake;
+		};
+
+		utl::vector<sleep_request> sleep_requests;
+		utl::vector<sleep_request> pending_sleep_requests;
+		std::mutex sleep_requests_mutex;
+
+		// Timed wakeups are kept in a hashed timer wheel. A timer is put into the slot of the tick it
+		// expires in, so adding a timer is O(1) and advancing the wheel only looks at the slots of the
+		// ticks that have passed. Timers that are more than one revolution away stay in their slot until due.
+		struct timer {
+			script_id id;
+			u32 serial;
+			u64 wake_tick;
+		};
+
+		constexpr u32 timer_wheel_size{ 256 };
+		constexpr f32 timer_resolution{ 1.f };	// length of one tick, in the units of dt
+		utl::vector<timer> timer_wheel[timer_wheel_size];
+		u64 current_tick{ 0 };
+		f32 time_in_tick{ 0.f };
+
 		using script_registry = std::unordered_map<size_t, detail::script_creator>;
 		script_registry& registry() {
 			// NOTE: I put this static variable in a function because of the initialization order of static data.
@@ -30,13 +111,184 @@ namespace primal::script {
 		bool exists(script_id id) {
 			assert(id::is_valid(id));
 			const id::id_type index{ id::index(id) };
-			assert(index < generations.size() &&
-				id_mapping[index] < entity_scripts.size());
+			assert(index < generations.size());
 			assert(generations[index] == id::generation(id));
+			const script_location& location{ id_mapping[index] };
 
 			return (generations[index] == id::generation(id)) &&
-				entity_scripts[id_mapping[index]] &&
-				entity_scripts[id_mapping[index]]->is_valid();
+				location.pool < pools.size() &&
+				location.index < pools[location.pool].ids.size() &&
+				pools[location.pool].ids[location.index] == id;
+		}
+
+		// Unlike exists(), these don't assert on stale ids, which are expected in timers and sleep requests.
+		bool is_alive(script_id id) {
+			const id::id_type index{ id::index(id) };
+			return generations[index] == id::generation(id) && id_mapping[index].pool != u32_invalid_id;
+		}
+
+		bool is_current(script_id id, u32 serial) {
+			return is_alive(id) && sleep_serials[id::index(id)] == serial;
+		}
+
+		u32 get_pool_index(detail::script_pool_base* pool) {
+			auto it = pool_indices.find(pool);
+			if (it != pool_indices.end()) return it->second;
+
+			const u32 index{ (u32)pools.size() };
+			pool_entry& entry{ pools.emplace_back() };
+			entry.pool = pool;
+			entry.uses_ticks = pool->tick_interval() > 1;
+			pool_indices[pool] = index;
+			return index;
+		}
+
+		void swap_scripts(pool_entry& entry, u32 a, u32 b) {
+			if (a == b) return;
+			entry.pool->swap(a, b);
+			std::swap(entry.ids[a], entry.ids[b]);
+			std::swap(entry.ticks[a], entry.ticks[b]);
+			id_mapping[id::index(entry.ids[a])].index = a;
+			id_mapping[id::index(entry.ids[b])].index = b;
+		}
+
+		void remove_from_pool(script_location location) {
+			pool_entry& entry{ pools[location.pool] };
+			// NOTE: move an active script to the end of the active range first, so that
+			//		 the last script of the pool, which may be sleeping, doesn't end up in the active range.
+			if (location.index < entry.active_count) {
+				--entry.active_count;
+				swap_scripts(entry, location.index, entry.active_count);
+				location.index = entry.active_count;
+			}
+
+			const script_id id{ entry.ids[location.index] };
+			const script_id last_id{ entry.ids.back() };
+
+			entry.pool->remove(location.index);
+			utl::erase_unordered(entry.ids, location.index);
+			utl::erase_unordered(entry.ticks, location.index);
+			id_mapping[id::index(last_id)] = location;
+			id_mapping[id::index(id)] = {};
+			++sleep_serials[id::index(id)];
+		}
+
+		void put_to_sleep(script_id id, f32 time) {
+			const id::id_type index{ id::index(id) };
+			const script_location location{ id_mapping[index] };
+			pool_entry& entry{ pools[location.pool] };
+			if (location.index < entry.active_count) {
+				--entry.active_count;
+				swap_scripts(entry, location.index, entry.active_count);
+			}
+
+			const u32 serial{ ++sleep_serials[index] };
+			if (time >= 0.f) {
+				const u64 wake_tick{ current_tick + std::max((u64)std::ceil(time / timer_resolution), (u64)1) };
+				timer_wheel[wake_tick % timer_wheel_size].emplace_back(timer{ id, serial, wake_tick });
+			}
+		}
+
+		void wake_up(script_id id) {
+			const id::id_type index{ id::index(id) };
+			const script_location location{ id_mapping[index] };
+			pool_entry& entry{ pools[location.pool] };
+			if (location.index < entry.active_count) return;
+
+			swap_scripts(entry, location.index, entry.active_count);
+			entry.ticks[entry.active_count].accumulated_dt = 0.f;
+			++entry.active_count;
+			++sleep_serials[index];
+		}
+
+		void advance_timers(f32 dt) {
+			time_in_tick += dt;
+			const u64 passed_ticks{ (u64)(time_in_tick / timer_resolution) };
+			if (!passed_ticks) return;
+			time_in_tick -= passed_ticks * timer_resolution;
+			const u64 new_tick{ current_tick + passed_ticks };
+			// NOTE: after a full revolution every slot has been visited, so don't go around more than once
+			const u64 first_tick{ std::max(current_tick + 1, new_tick >= timer_wheel_size ? new_tick - timer_wheel_size + 1 : 0) };
+			current_tick = new_tick;
+
+			for (u64 tick{ first_tick }; tick <= new_tick; ++tick) {
+				utl::vector<timer>& slot{ timer_wheel[tick % timer_wheel_size] };
+				u32 i{ 0 };
+				while (i < slot.size()) {
+					const timer t{ slot[i] };
+					if (t.wake_tick > new_tick) {
+						++i;
+						continue;
+					}
+
+					utl::erase_unordered(slot, i);
+					if (is_current(t.id, t.serial)) wake_up(t.id);
+				}
+			}
+		}
+
+		void apply_sleep_requests() {
+			{
+				std::lock_guard lock{ sleep_requests_mutex };
+				sleep_requests.swap(pending_sleep_requests);
+			}
+
+			for (const sleep_request& r : sleep_requests) {
+				// NOTE: don't compare sleep serials here. A sleep request changes the serial, which would drop
+				//		 a wake request for the same script from the same frame.
+				if (!is_alive(r.id)) continue;
+				if (r.wake) wake_up(r.id);
+				else put_to_sleep(r.id, r.time);
+			}
+			sleep_requests.clear();
+		}
+
+		bool update_low_priority_slice(void*) {
+			DEBUG_OP(is_updating = true);
+			u32 remaining{ low_priority_slice_size };
+			// NOTE: scripts may be added, removed or put to sleep between two slices. This can make a pass skip
+			//		 or repeat a script, which is fine because the accumulated dt is passed to update().
+			while (remaining && low_priority_pool < pools.size()) {
+				pool_entry& entry{ pools[low_priority_pool] };
+				if (entry.pool->priority() != update_priority::low || low_priority_index >= entry.active_count) {
+					++low_priority_pool;
+					low_priority_index = 0;
+					continue;
+				}
+
+				const u32 last{ std::min(entry.active_count, low_priority_index + remaining) };
+				due_indices.clear();
+				due_dts.clear();
+				for (u32 i{ low_priority_index }; i < last; ++i) {
+					due_indices.emplace_back(i);
+					due_dts.emplace_back(entry.ticks[i].accumulated_dt);
+					entry.ticks[i].accumulated_dt = 0.f;
+				}
+
+				entry.pool->update(due_indices.data(), due_dts.data(), (u32)due_indices.size());
+				remaining -= last - low_priority_index;
+				low_priority_index = last;
+			}
+			DEBUG_OP(is_updating = false);
+
+			if (low_priority_pool < pools.size()) return false;
+			low_priority_pass_pending = false;
+			return true;
+		}
+
+		size_t tag_of(const detail::script_pool_base* const pool) {
+			for (const auto& [tag, creator] : registry()) {
+				if (&creator() == pool) return tag;
+			}
+
+			assert(false); // all pools belong to registered script types
+			return 0;
+		}
+
+		void request_sleep(script_id id, f32 time, bool wake) {
+			assert(id::is_valid(id));
+			std::lock_guard lock{ sleep_requests_mutex };
+			pending_sleep_requests.emplace_back(sleep_request{ id, time, wake });
 		}
 	}  // anonymous namespace
 
@@ -49,8 +301,7 @@ namespace primal::script {
 
 		script_creator get_script_creator(size_t tag) {
 			auto script = primal::script::registry().find(tag);
-			assert(script != primal::script::registry().end() && script->first == tag);
-			return script->second;
+			return script != primal::script::registry().end() ? script->second : nullptr;
 		}
 
 #ifdef USE_WITH_EDITOR
@@ -64,6 +315,7 @@ namespace primal::script {
 	component create(init_info info, game_entity::entity entity) {
 		assert(entity.is_valid());
 		assert(info.script_creator);
+		DEBUG_OP(assert(!is_updating));
 
 		script_id id{};
 		if (free_ids.size() > id::min_deleted_elements) {
@@ -76,33 +328,321 @@ namespace primal::script {
 		else {
 			id = script_id{ (id::id_type)id_mapping.size() };
 			id_mapping.emplace_back();
+			sleep_serials.emplace_back(0);
 			generations.push_back(0);
 		}
 
 		assert(id::is_valid(id));
-		const id::id_type index{ (id::id_type)entity_scripts.size() };
-		entity_scripts.emplace_back(info.script_creator(entity));
-		assert(entity_scripts.back()->get_id() == entity.get_id());
-		id_mapping[id::index(id)] = index;
+		const u32 pool_index{ get_pool_index(&info.script_creator()) };
+		pool_entry& entry{ pools[pool_index] };
+		const u32 index{ entry.pool->size() };
+		[[maybe_unused]] const entity_script& script{ entry.pool->create(entity) };
+		assert(script.get_id() == entity.get_id());
+		entry.ids.emplace_back(id);
+		assert(entry.ids.size() == entry.pool->size());
+		id_mapping[id::index(id)] = { pool_index, index };
+
+		// NOTE: consecutive scripts get consecutive phases, so that scripts which don't tick
+		//		 every frame are spread evenly over the frames of their interval.
+		tick_state& tick{ entry.ticks.emplace_back() };
+		tick.phase = entry.next_phase++;
+		tick.base_interval = tick.interval = std::max(entry.pool->tick_interval(), 1u);
+
+		// new scripts are awake
+		swap_scripts(entry, index, entry.active_count);
+		++entry.active_count;
 
 		return component{ id };
 	}
 
 	void remove(component c) {
 		assert(c.is_valid() && exists(c.get_id()));
-		const script_id id{ c.get_id() };
-		const id::id_type index{ id_mapping[id::index(id)] };
-		const script_id last_id{ entity_scripts.back()->script().get_id() };
+		DEBUG_OP(assert(!is_updating));
+		remove_from_pool(id_mapping[id::index(c.get_id())]);
+	}
 
-		utl::erase_unordered(entity_scripts, index);
-		id_mapping[id::index(last_id)] = index;
-		id_mapping[id::index(id)] = id::invalid_id;
+	void remove_many(const component* const components, u32 count) {
+		assert(components && count);
+		DEBUG_OP(assert(!is_updating));
+		if (!components || !count) return;
+
+		utl::vector<script_location> locations{};
+		locations.reserve(count);
+		for (u32 i{ 0 }; i < count; ++i) {
+			const component c{ components[i] };
+			assert(c.is_valid() && exists(c.get_id()));
+			locations.emplace_back(id_mapping[id::index(c.get_id())]);
+		}
+
+		// NOTE: within each pool, erase from the highest index down. This way, the last script that is
+		//		 swapped into a removed slot is never one that is still waiting to be removed.
+		std::sort(locations.begin(), locations.end(), [](script_location a, script_location b) {
+			return a.pool != b.pool ? a.pool < b.pool : a.index > b.index;
+			});
+
+		for (const script_location location : locations) {
+			remove_from_pool(location);
+		}
 	}
 
 	void update(float dt) {
-		for (auto& ptr : entity_scripts) {
-			ptr->update(dt);
+		advance_timers(dt);
+		apply_sleep_requests();
+
+		DEBUG_OP(is_updating = true);
+		++frame;
+		bool has_low_priority{ false };
+		for (pool_entry& entry : pools) {
+			detail::script_pool_base* const pool{ entry.pool };
+			if (pool->priority() == update_priority::low) {
+				for (u32 i{ 0 }; i < entry.active_count; ++i) {
+					entry.ticks[i].accumulated_dt += dt;
+				}
+				has_low_priority |= entry.active_count > 0;
+				continue;
+			}
+
+			const bool in_parallel{ parallel_update && pool->access() == update_access::own_entity };
+
+			if (!entry.uses_ticks && !update_lod) {
+				if (in_parallel) {
+					jobs::parallel_for(entry.active_count, parallel_update_range_size, [pool, dt](u32 first, u32 last) {
+						pool->update(first, last, dt);
+						});
+				}
+				else {
+					pool->update(0, entry.active_count, dt);
+				}
+				continue;
+			}
+
+			// collect the scripts that are due this frame and the time since their last update
+			due_indices.clear();
+			due_dts.clear();
+			for (u32 i{ 0 }; i < entry.active_count; ++i) {
+				tick_state& tick{ entry.ticks[i] };
+				tick.accumulated_dt += dt;
+				if ((frame + tick.phase) % tick.interval) continue;
+
+				due_indices.emplace_back(i);
+				due_dts.emplace_back(tick.accumulated_dt);
+				tick.accumulated_dt = 0.f;
+				if (update_lod) {
+					const u32 lod{ update_lod(game_entity::entity{ pool->get(i).get_id() }) };
+					tick.interval = tick.base_interval * std::max(lod, 1u);
+				}
+			}
+
+			const u32* const indices{ due_indices.data() };
+			const f32* const dts{ due_dts.data() };
+			if (in_parallel) {
+				jobs::parallel_for((u32)due_indices.size(), parallel_update_range_size, [pool, indices, dts](u32 first, u32 last) {
+					pool->update(&indices[first], &dts[first], last - first);
+					});
+			}
+			else {
+				pool->update(indices, dts, (u32)due_indices.size());
+			}
+		}
+		DEBUG_OP(is_updating = false);
+
+		if (has_low_priority && !low_priority_pass_pending) {
+			low_priority_pass_pending = true;
+			low_priority_pool = 0;
+			low_priority_index = 0;
+			scheduler::add_task(scheduler::category::scripts, update_low_priority_slice, nullptr);
+		}
+	}
+
+	void set_parallel_update(bool enable) {
+		parallel_update = enable;
+	}
+
+	void set_tick_interval(component c, u32 interval) {
+		assert(c.is_valid() && exists(c.get_id()));
+		assert(interval);
+		const script_location location{ id_mapping[id::index(c.get_id())] };
+		pool_entry& entry{ pools[location.pool] };
+		tick_state& tick{ entry.ticks[location.index] };
+		tick.base_interval = tick.interval = std::max(interval, 1u);
+		entry.uses_ticks = true;
+	}
+
+	void set_update_lod(update_lod_func func) {
+		update_lod = func;
+	}
+
+	u64 snapshot_size() {
+		u64 size{ sizeof(u32) + sizeof(u64) + sizeof(f32) + utl::vector_blob_size(generations) + utl::vector_blob_size(sleep_serials) +
+			sizeof(u32) + free_ids.size() * sizeof(script_id) + sizeof(u32) };
+		for (const utl::vector<timer>& slot : timer_wheel) size += utl::vector_blob_size(slot);
+
+		for (const pool_entry& entry : pools) {
+			if (entry.ids.empty()) continue;
+			size += sizeof(u64) + 2 * sizeof(u32) + sizeof(u8) + utl::vector_blob_size(entry.ids) + utl::vector_blob_size(entry.ticks);
+			for (u32 i{ 0 }; i < entry.pool->size(); ++i) {
+				size += sizeof(id::id_type) + sizeof(u32) + entry.pool->get(i).state_size();
+			}
+		}
+
+		return size;
+	}
+
+	void save_snapshot(utl::blob_stream_writer& writer) {
+		writer.write(frame);
+		writer.write(current_tick);
+		writer.write(time_in_tick);
+		writer.write_vector(generations);
+		writer.write_vector(sleep_serials);
+		writer.write((u32)free_ids.size());
+		for (const script_id id : free_ids) writer.write((id::id_type)id);
+		for (const utl::vector<timer>& slot : timer_wheel) writer.write_vector(slot);
+
+		u32 pools_in_use{ 0 };
+		for (const pool_entry& entry : pools) pools_in_use += entry.ids.empty() ? 0 : 1;
+		writer.write(pools_in_use);
+
+		// NOTE: pool indices depend on the order in which script types were first used,
+		//		 so pools are identified by the tag of their script type.
+		for (const pool_entry& entry : pools) {
+			if (entry.ids.empty()) continue;
+			writer.write((u64)tag_of(entry.pool));
+			writer.write(entry.active_count);
+			writer.write(entry.next_phase);
+			writer.write((u8)entry.uses_ticks);
+			writer.write_vector(entry.ids);
+			writer.write_vector(entry.ticks);
+
+			for (u32 i{ 0 }; i < entry.pool->size(); ++i) {
+				const entity_script& script{ entry.pool->get(i) };
+				const u32 state_size{ script.state_size() };
+				writer.write((id::id_type)script.get_id());
+				writer.write(state_size);
+				if (state_size) {
+					script.save_state((u8*)writer.position());
+					writer.skip(state_size);
+				}
+			}
+		}
+	}
+
+	bool validate_snapshot(const u8* const data, u64 size) {
+		utl::blob_stream_reader reader{ data };
+		// NOTE: the image may be damaged, so every step is checked against the size of the section
+		const auto has = [&](u64 bytes) { return reader.offset() + bytes <= size; };
+		const auto skip_vector = [&](u64 item_size, u32& count) {
+			if (!has(sizeof(u32))) return false;
+			count = reader.read<u32>();
+			if (!has(count * item_size)) return false;
+			reader.skip(count * item_size);
+			return true;
+		};
+
+		if (!has(sizeof(u32) + sizeof(u64) + sizeof(f32))) return false;
+		reader.skip(sizeof(u32) + sizeof(u64) + sizeof(f32));
+		u32 generation_count, serial_count, count;
+		if (!skip_vector(sizeof(id::generation_type), generation_count) || !skip_vector(sizeof(u32), serial_count)) return false;
+		if (generation_count != serial_count || !skip_vector(sizeof(id::id_type), count)) return false;
+		for (u32 i{ 0 }; i < timer_wheel_size; ++i) {
+			if (!skip_vector(sizeof(timer), count)) return false;
+		}
+
+		if (!has(sizeof(u32))) return false;
+		const u32 pools_in_use{ reader.read<u32>() };
+		for (u32 p{ 0 }; p < pools_in_use; ++p) {
+			if (!has(sizeof(u64) + 2 * sizeof(u32) + sizeof(u8))) return false;
+			// NOTE: the script type may have been renamed or removed since the snapshot was taken
+			if (registry().find((size_t)reader.read<u64>()) == registry().end()) return false;
+			const u32 active_count{ reader.read<u32>() };
+			reader.skip(sizeof(u32) + sizeof(u8));
+
+			const u8* const ids{ reader.position() + sizeof(u32) };
+			u32 id_count, tick_count;
+			if (!skip_vector(sizeof(script_id), id_count) || !skip_vector(sizeof(tick_state), tick_count)) return false;
+			if (id_count != tick_count || active_count > id_count) return false;
+			for (u32 i{ 0 }; i < id_count; ++i) {
+				id::id_type id;
+				memcpy(&id, ids + i * sizeof(script_id), sizeof(id));
+				if (!id::is_valid(id) || id::index(id) >= generation_count) return false;
+
+				if (!has(sizeof(id::id_type) + sizeof(u32))) return false;
+				reader.skip(sizeof(id::id_type));
+				const u32 state_size{ reader.read<u32>() };
+				if (!has(state_size)) return false;
+				reader.skip(state_size);
+			}
+		}
+
+		return reader.offset() == size;
+	}
+
+	bool restore_snapshot(utl::blob_stream_reader& reader) {
+		DEBUG_OP(assert(!is_updating));
+		for (pool_entry& entry : pools) {
+			for (u32 i{ entry.pool->size() }; i > 0; --i) entry.pool->remove(i - 1);
+			entry.ids.clear();
+			entry.ticks.clear();
+			entry.active_count = 0;
+			entry.next_phase = 0;
+		}
+
+		frame = reader.read<u32>();
+		current_tick = reader.read<u64>();
+		time_in_tick = reader.read<f32>();
+		reader.read_vector(generations);
+		reader.read_vector(sleep_serials);
+		assert(generations.size() == sleep_serials.size());
+		id_mapping.clear();
+		id_mapping.resize(generations.size());
+
+		free_ids.clear();
+		const u32 free_count{ reader.read<u32>() };
+		for (u32 i{ 0 }; i < free_count; ++i) free_ids.emplace_back(reader.read<id::id_type>());
+		for (utl::vector<timer>& slot : timer_wheel) reader.read_vector(slot);
+
+		{
+			std::lock_guard lock{ sleep_requests_mutex };
+			pending_sleep_requests.clear();
+		}
+		low_priority_pool = 0;
+		low_priority_index = 0;
+
+		const u32 pools_in_use{ reader.read<u32>() };
+		for (u32 p{ 0 }; p < pools_in_use; ++p) {
+			const auto creator = registry().find((size_t)reader.read<u64>());
+			if (creator == registry().end()) return false;
+			const u32 pool_index{ get_pool_index(&creator->second()) };
+			pool_entry& entry{ pools[pool_index] };
+			entry.active_count = reader.read<u32>();
+			entry.next_phase = reader.read<u32>();
+			entry.uses_ticks |= reader.read<u8>() != 0;
+			reader.read_vector(entry.ids);
+			reader.read_vector(entry.ticks);
+			assert(entry.ids.size() == entry.ticks.size() && entry.active_count <= entry.ids.size());
+
+			for (u32 i{ 0 }; i < entry.ids.size(); ++i) {
+				const game_entity::entity entity{ game_entity::entity_id{ reader.read<id::id_type>() } };
+				entity_script& script{ entry.pool->create(entity) };
+				const u32 state_size{ reader.read<u32>() };
+				if (state_size) {
+					script.load_state(reader.position(), state_size);
+					reader.skip(state_size);
+				}
+				id_mapping[id::index(entry.ids[i])] = { pool_index, i };
+			}
 		}
+
+		return true;
+	}
+
+	void component::sleep(float time) {
+		assert(is_valid());
+		request_sleep(_id, time, false);
+	}
+
+	void component::wake() {
+		assert(is_valid());
+		request_sleep(_id, -1.f, true);
 	}
 }  // namespace primal::script
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "ComponentsCommon.h"
+#include "..\Utilities\IOStream.h"
 
 namespace primal::script {
 
@@ -10,6 +11,28 @@ namespace primal::script {
 
 	component create(init_info info, game_entity::entity entity);
 	void remove(component c);
+	void remove_many(const component* const components, u32 count);
 	void update(float dt);
 
+	// When enabled, script types that declare update_access::own_entity are updated in parallel
+	// using the job system. All other scripts are still updated serially on the calling thread.
+	void set_parallel_update(bool enable);
+
+	// Overrides the tick interval of a single script. See entity_script::tick_interval.
+	void set_tick_interval(component c, u32 interval);
+
+	// Returns a multiplier (>= 1) for the tick interval of a script, e.g. based on its distance to the camera.
+	// It's called whenever a script ticks, so the new interval takes effect from its next update.
+	using update_lod_func = u32(*)(game_entity::entity entity);
+	void set_update_lod(update_lod_func func);
+
+	// Snapshots (see snapshot::save()). Scripts are saved as their type and the state from entity_script::save_state().
+	// Restoring destroys all scripts and creates the saved ones. Sleep and wake requests that weren't applied yet are dropped.
+	[[nodiscard]] u64 snapshot_size();
+	void save_snapshot(utl::blob_stream_writer& writer);
+	// Checks the 'size' bytes of the script section at 'data' without changing anything. Fails if a script type isn't registered.
+	[[nodiscard]] bool validate_snapshot(const u8* const data, u64 size);
+	// Returns false if a script type isn't registered. Scripts may have been removed already, so validate first.
+	bool restore_snapshot(utl::blob_stream_reader& reader);
+
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "Snapshot.h"
+#include "Entity.h"
+#include "Transform.h"
+#include "Script.h"
+#include "RigidBody.h"
+#include "Tags.h"
+#include "ChangeJournal.h"
+#include "EntityCommands.h"
+#include "EventBus.h"
+#include "..\Spatial\Spatial.h"
+
+#include <fstream>
+#include <filesystem>
+
+namespace primal::snapshot {
+
+	// anonymous namespace
+	namespace {
+		constexpr u32 snapshot_magic{ 0x504e5350 }; // "PSNP"
+		constexpr u32 snapshot_version{ 3 };
+
+		// NOTE: modules are restored in this order. Rigid bodies need transforms,
+		//		 scripts are created for live entities and the spatial index is built from transforms.
+		enum section : u32 {
+			entities,
+			transforms,
+			rigid_bodies,
+			scripts,
+			spatial_index,
+			tags,
+
+			count
+		};
+
+		struct header {
+			u32 magic;
+			u32 version;
+			u64 size;	// including the header
+			u64 section_sizes[section::count];
+		};
+
+		void get_section_sizes(u64(&sizes)[section::count]) {
+			sizes[section::entities] = game_entity::snapshot_size();
+			sizes[section::transforms] = transform::snapshot_size();
+			sizes[section::rigid_bodies] = rigid_body::snapshot_size();
+			sizes[section::scripts] = script::snapshot_size();
+			sizes[section::spatial_index] = spatial::snapshot_size();
+			sizes[section::tags] = tags::snapshot_size();
+		}
+	} // anonymous namespace
+
+	u64 size() {
+		u64 sizes[section::count];
+		get_section_sizes(sizes);
+		u64 total{ sizeof(header) };
+		for (const u64 s : sizes) total += s;
+		return total;
+	}
+
+	void save(utl::vector<u8>& image) {
+		header h{ snapshot_magic, snapshot_version, sizeof(header) };
+		get_section_sizes(h.section_sizes);
+		for (const u64 s : h.section_sizes) h.size += s;
+		image.resize(h.size);
+		utl::blob_stream_writer writer{ image.data(), image.size() };
+		writer.write((const u8*)&h, sizeof(header));
+
+		game_entity::save_snapshot(writer);
+		transform::save_snapshot(writer);
+		rigid_body::save_snapshot(writer);
+		script::save_snapshot(writer);
+		spatial::save_snapshot(writer);
+		tags::save_snapshot(writer);
+		assert(writer.offset() == h.size);
+	}
+
+	bool save(const char* path) {
+		assert(path);
+		utl::vector<u8> image;
+		save(image);
+
+		std::ofstream file{ path, std::ios::out | std::ios::binary };
+		return file && file.write((const char*)image.data(), image.size());
+	}
+
+	bool restore(const u8* const image, u64 size) {
+		assert(image);
+		header h;
+		if (size < sizeof(header)) return false;
+		memcpy(&h, image, sizeof(header));
+		if (h.magic != snapshot_magic || h.version != snapshot_version || h.size != size) return false;
+
+		const u8* sections[section::count];
+		u64 offset{ sizeof(header) };
+		for (u32 i{ 0 }; i < section::count; ++i) {
+			if (h.section_sizes[i] > size - offset) return false;
+			sections[i] = image + offset;
+			offset += h.section_sizes[i];
+		}
+		if (offset != size) return false;
+
+		// NOTE: check everything that can fail before the world is changed
+		if (!game_entity::validate_snapshot(sections[section::entities], h.section_sizes[section::entities]) ||
+			!script::validate_snapshot(sections[section::scripts], h.section_sizes[section::scripts])) {
+			return false;
+		}
+
+		// commands and events that refer to the old world
+		game_entity::discard_commands();
+		events::discard();
+
+		utl::blob_stream_reader reader{ image };
+		reader.skip(sizeof(header));
+		if (!game_entity::restore_snapshot(reader)) return false;
+		assert(reader.position() == sections[section::transforms]);
+		transform::restore_snapshot(reader);
+		assert(reader.position() == sections[section::rigid_bodies]);
+		rigid_body::restore_snapshot(reader);
+		assert(reader.position() == sections[section::scripts]);
+		[[maybe_unused]] const bool scripts_restored{ script::restore_snapshot(reader) };
+		assert(scripts_restored && reader.position() == sections[section::spatial_index]);
+		spatial::restore_snapshot(reader);
+		assert(reader.position() == sections[section::tags]);
+		tags::restore_snapshot(reader);
+		assert(reader.offset() == size);
+		journal::record_reset();
+		return true;
+	}
+
+	bool load(const char* path) {
+		assert(path);
+		if (!std::filesystem::exists(path)) return false;
+
+		const u64 size{ std::filesystem::file_size(path) };
+		std::unique_ptr<u8[]> image{ std::make_unique<u8[]>(size) };
+		std::ifstream file{ path, std::ios::in | std::ios::binary };
+		if (!file || !file.read((char*)image.get(), size)) return false;
+
+		return restore(image.get(), size);
+	}
+}
\ No newline at end of file
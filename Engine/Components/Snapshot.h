@@ -0,0 +1,26 @@
+#pragma once
+#include "ComponentsCommon.h"
+
+namespace primal::snapshot {
+
+	// A snapshot is a binary image of the whole world: entities, their components and the spatial index.
+	// Component data is copied as it is stored, so saving and restoring is mostly a few large copies.
+	// Scripts are the exception, because they are recreated from their type and state
+	// (see entity_script::save_state()).
+	// NOTE: take and restore snapshots between frames, after game_entity::flush_commands().
+	//		 Images are only compatible with builds that have the same version and component layout.
+
+	// Number of bytes that save() writes
+	[[nodiscard]] u64 size();
+	void save(utl::vector<u8>& image);
+	// Writes the image to a file with one write
+	bool save(const char* path);
+
+	// Replaces the world with the one in the image. Returns false, without changing the world, if the image
+	// isn't a snapshot of this version, is damaged or has scripts whose types aren't registered in this build.
+	// Entity commands and events that weren't applied or delivered yet are dropped.
+	// NOTE: content streaming isn't part of the snapshot. Loaded cells keep the ids of the entities they created,
+	//		 and the ones that don't exist in the restored world are skipped when the cell is unloaded.
+	bool restore(const u8* const image, u64 size);
+	bool load(const char* path);
+}
\ No newline at end of file
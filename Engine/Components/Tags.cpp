@@ -0,0 +1,293 @@
+#include "Tags.h"
+#include "Entity.h"
+
+#include <bit>
+
+namespace primal::tags {
+
+	// anonymous namespace
+	namespace {
+		using game_entity::entity_id;
+
+		// Set of entities with constant time add, remove and lookup. The entities are stored in a dense list,
+		// which can be iterated directly. The position of each entity in the list is stored in pages,
+		// which are allocated when an entity with an index in their range is added for the first time.
+		class entity_set {
+		public:
+			void add(entity_id id) {
+				position(id::index(id)) = (u32)_entities.size();
+				_entities.emplace_back(id);
+			}
+
+			// NOTE: the last entity is moved into the place of the removed one, so removing doesn't keep the order
+			void remove(entity_id id) {
+				u32& p{ position(id::index(id)) };
+				assert(p < _entities.size() && _entities[p] == id);
+				const entity_id last{ _entities.back() };
+				_entities[p] = last;
+				position(id::index(last)) = p;
+				_entities.pop_back();
+				p = u32_invalid_id;
+			}
+
+			void clear() {
+				for (const entity_id id : _entities) position(id::index(id)) = u32_invalid_id;
+				_entities.clear();
+			}
+
+			[[nodiscard]] const utl::vector<entity_id>& entities() const { return _entities; }
+
+		private:
+			static constexpr u32 page_size{ 1024 };
+
+			u32& position(id::id_type index) {
+				const u32 page{ index / page_size };
+				while (_pages.size() <= page) _pages.emplace_back();
+				if (!_pages[page]) {
+					_pages[page] = std::make_unique<u32[]>(page_size);
+					memset(_pages[page].get(), 0xff, page_size * sizeof(u32));
+				}
+				return _pages[page][index % page_size];
+			}
+
+			utl::vector<entity_id> _entities;
+			utl::vector<std::unique_ptr<u32[]>> _pages;
+		};
+
+		struct entity_record {
+			entity_id id{ id::invalid_id };
+			tag_mask mask{ 0 };
+			u32 name{ u32_invalid_id };
+			u32 name_position{ 0 };	// position of the entity in the list of entities with its name
+		};
+
+		// indexed by id::index() of the entity id. Only entities with a name or a tag use their record.
+		utl::vector<entity_record> records;
+
+		// NOTE: the keys of the map don't move when it grows, so interned strings can point to them
+		std::unordered_map<std::string, u32> string_ids;
+		utl::vector<const char*> strings;
+		// entities with each name, indexed by string id
+		utl::vector<utl::vector<entity_id>> named_entities;
+
+		u32 tag_strings[max_tags]{};
+		u32 tag_count{ 0 };
+		entity_set tag_sets[max_tags];
+
+		const utl::vector<entity_id> no_entities{};
+
+		u32 intern(const char* s) {
+			const auto [it, is_new] { string_ids.try_emplace(s, (u32)strings.size()) };
+			if (is_new) {
+				strings.emplace_back(it->first.c_str());
+				named_entities.emplace_back();
+			}
+			return it->second;
+		}
+
+		u32 find_string(const char* s) {
+			const auto it{ string_ids.find(s) };
+			return it == string_ids.end() ? u32_invalid_id : it->second;
+		}
+
+		entity_record& record_of(entity_id id) {
+			assert(game_entity::is_alive(id));
+			const id::id_type index{ id::index(id) };
+			while (records.size() <= index) records.emplace_back();
+			entity_record& r{ records[index] };
+			r.id = id;
+			return r;
+		}
+
+		// Returns u32_invalid_id when all tags are in use
+		u32 find_or_add_tag(u32 s) {
+			for (u32 i{ 0 }; i < tag_count; ++i) {
+				if (tag_strings[i] == s) return i;
+			}
+
+			if (tag_count == max_tags) return u32_invalid_id;
+			tag_strings[tag_count] = s;
+			return tag_count++;
+		}
+
+		const entity_record* find_record(entity_id id) {
+			assert(game_entity::is_alive(id));
+			const id::id_type index{ id::index(id) };
+			return (index < records.size() && records[index].id == id) ? &records[index] : nullptr;
+		}
+
+		void remove_name(entity_record& r) {
+			if (r.name == u32_invalid_id) return;
+			utl::vector<entity_id>& list{ named_entities[r.name] };
+			const entity_id last{ list.back() };
+			list[r.name_position] = last;
+			records[id::index(last)].name_position = r.name_position;
+			list.pop_back();
+			r.name = u32_invalid_id;
+		}
+
+		u64 string_blob_size(u32 s) {
+			return sizeof(u32) + (s == u32_invalid_id ? 0 : strlen(strings[s]));
+		}
+
+		void write_string(utl::blob_stream_writer& writer, u32 s) {
+			const u32 length{ s == u32_invalid_id ? 0 : (u32)strlen(strings[s]) };
+			writer.write(length);
+			if (length) writer.write(strings[s], length);
+		}
+
+		std::string read_string(utl::blob_stream_reader& reader) {
+			std::string s(reader.read<u32>(), '\0');
+			reader.read((u8*)s.data(), s.size());
+			return s;
+		}
+	} // anonymous namespace
+
+	u32 get_tag(const char* name) {
+		assert(name && *name);
+		const u32 tag{ find_or_add_tag(intern(name)) };
+		assert(tag != u32_invalid_id);
+		return tag;
+	}
+
+	void add_tag(entity_id id, u32 tag) {
+		assert(tag < tag_count);
+		if (tag >= tag_count) return;
+		entity_record& r{ record_of(id) };
+		if (r.mask & to_mask(tag)) return;
+		r.mask |= to_mask(tag);
+		tag_sets[tag].add(id);
+	}
+
+	void remove_tag(entity_id id, u32 tag) {
+		assert(tag < tag_count);
+		const id::id_type index{ id::index(id) };
+		if (!find_record(id) || !(records[index].mask & to_mask(tag))) return;
+		records[index].mask &= ~to_mask(tag);
+		tag_sets[tag].remove(id);
+	}
+
+	tag_mask get_tags(entity_id id) {
+		const entity_record* const r{ find_record(id) };
+		return r ? r->mask : 0;
+	}
+
+	bool has_tags(entity_id id, tag_mask mask) {
+		return (get_tags(id) & mask) == mask;
+	}
+
+	const utl::vector<entity_id>& with_tag(u32 tag) {
+		assert(tag < tag_count);
+		return tag < tag_count ? tag_sets[tag].entities() : no_entities;
+	}
+
+	void with_tags(tag_mask mask, utl::vector<entity_id>& results) {
+		if (!mask) return;
+
+		// NOTE: every result has the rarest tag, so only its entities need to be checked
+		u32 rarest{ u32_invalid_id };
+		for (tag_mask m{ mask }; m; m &= m - 1) {
+			const u32 tag{ (u32)std::countr_zero(m) };
+			if (tag >= tag_count) return;
+			if (rarest == u32_invalid_id || tag_sets[tag].entities().size() < tag_sets[rarest].entities().size()) rarest = tag;
+		}
+
+		for (const entity_id id : tag_sets[rarest].entities()) {
+			if ((records[id::index(id)].mask & mask) == mask) results.emplace_back(id);
+		}
+	}
+
+	void set_name(entity_id id, const char* name) {
+		entity_record& r{ record_of(id) };
+		remove_name(r);
+		if (!name || !*name) return;
+
+		r.name = intern(name);
+		utl::vector<entity_id>& list{ named_entities[r.name] };
+		r.name_position = (u32)list.size();
+		list.emplace_back(id);
+	}
+
+	const char* get_name(entity_id id) {
+		const entity_record* const r{ find_record(id) };
+		return (r && r->name != u32_invalid_id) ? strings[r->name] : "";
+	}
+
+	entity_id find(const char* name) {
+		const utl::vector<entity_id>& list{ find_all(name) };
+		return list.empty() ? entity_id{ id::invalid_id } : list[0];
+	}
+
+	const utl::vector<entity_id>& find_all(const char* name) {
+		assert(name);
+		const u32 s{ find_string(name) };
+		return s == u32_invalid_id ? no_entities : named_entities[s];
+	}
+
+	void remove(entity_id id) {
+		const id::id_type index{ id::index(id) };
+		if (index >= records.size() || records[index].id != id) return;
+
+		entity_record& r{ records[index] };
+		for (tag_mask m{ r.mask }; m; m &= m - 1) {
+			tag_sets[std::countr_zero(m)].remove(id);
+		}
+
+		remove_name(r);
+		r = {};
+	}
+
+	u64 snapshot_size() {
+		u64 size{ 2 * sizeof(u32) };
+		for (u32 i{ 0 }; i < tag_count; ++i) size += string_blob_size(tag_strings[i]);
+		for (const entity_record& r : records) {
+			if (!r.mask && r.name == u32_invalid_id) continue;
+			size += sizeof(id::id_type) + sizeof(tag_mask) + string_blob_size(r.name);
+		}
+
+		return size;
+	}
+
+	void save_snapshot(utl::blob_stream_writer& writer) {
+		writer.write(tag_count);
+		for (u32 i{ 0 }; i < tag_count; ++i) write_string(writer, tag_strings[i]);
+
+		u32 entity_count{ 0 };
+		for (const entity_record& r : records) entity_count += (r.mask || r.name != u32_invalid_id) ? 1 : 0;
+		writer.write(entity_count);
+		for (const entity_record& r : records) {
+			if (!r.mask && r.name == u32_invalid_id) continue;
+			writer.write((id::id_type)r.id);
+			writer.write(r.mask);
+			write_string(writer, r.name);
+		}
+	}
+
+	void restore_snapshot(utl::blob_stream_reader& reader) {
+		for (u32 i{ 0 }; i < tag_count; ++i) tag_sets[i].clear();
+		for (utl::vector<entity_id>& list : named_entities) list.clear();
+		records.clear();
+
+		// NOTE: tags of the snapshot may have other ids in this process. When this process has interned other tags,
+		//		 there may be no room left for some of them. Those tags are dropped.
+		u32 snapshot_tags[max_tags];
+		const u32 snapshot_tag_count{ reader.read<u32>() };
+		for (u32 i{ 0 }; i < snapshot_tag_count; ++i) {
+			const std::string name{ read_string(reader) };
+			if (i >= max_tags) continue;
+			snapshot_tags[i] = name.empty() ? u32_invalid_id : find_or_add_tag(intern(name.c_str()));
+		}
+
+		const u32 entity_count{ reader.read<u32>() };
+		for (u32 i{ 0 }; i < entity_count; ++i) {
+			const entity_id id{ reader.read<id::id_type>() };
+			const tag_mask mask{ reader.read<tag_mask>() };
+			for (tag_mask m{ mask }; m; m &= m - 1) {
+				const u32 bit{ (u32)std::countr_zero(m) };
+				if (bit >= snapshot_tag_count || snapshot_tags[bit] == u32_invalid_id) continue;
+				add_tag(id, snapshot_tags[bit]);
+			}
+			set_name(id, read_string(reader).c_str());
+		}
+	}
+}
\ No newline at end of file
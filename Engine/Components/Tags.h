@@ -0,0 +1,17 @@
+#pragma once
+#include "ComponentsCommon.h"
+#include "..\EngineAPI\Tags.h"
+#include "..\Utilities\IOStream.h"
+
+namespace primal::tags {
+
+	// Removes the name and the tags of an entity that is being removed
+	void remove(game_entity::entity_id id);
+
+	// Snapshots (see snapshot::save()). Names and tags are saved as strings,
+	// so a snapshot can be restored in a process that interned them in a different order. Tags of the snapshot
+	// that don't fit into the 64 tags of this process anymore are dropped.
+	[[nodiscard]] u64 snapshot_size();
+	void save_snapshot(utl::blob_stream_writer& writer);
+	void restore_snapshot(utl::blob_stream_reader& reader);
+}
\ No newline at end of file
@@ -1,49 +1,402 @@
 #include "Transform.h"
 #include "Entity.h"
+#include "ChangeJournal.h"
+#include "..\Core\Scheduler.h"
+
+#include <algorithm>
+#include <atomic>
 
 namespace primal::transform {
 
 	// anonymous namespace
 	namespace {
+		// NOTE: transform data is stored in slots. Removing a transform leaves a hole, so slots don't move
+		//		 during a frame. The compaction task moves the last transforms into the holes a few at a time
+		//		 and then releases the memory, so the arrays track the number of live transforms.
 		utl::vector<math::v4> rotations;
 		utl::vector<math::v3> positions;
 		utl::vector<math::v3> scales;
-	}
+		utl::vector<math::m4x4a> world;
+		utl::vector<transform_id> owners;	// transform id of each slot, invalid for holes
+		// NOTE: poses at the start of the last simulation step. Rendering interpolates between these and the current poses.
+		utl::vector<math::v4> previous_rotations;
+		utl::vector<math::v3> previous_positions;
+
+		// slot of each transform, indexed by id::index() of the transform id
+		utl::vector<u32> slots;
+		u32 hole_count{ 0 };
+		u32 first_hole{ u32_invalid_id };	// no hole has a lower slot than this one
+		bool compaction_pending{ false };
+		constexpr u32 compaction_slice_size{ 256 };
+
+		// NOTE: change flags are indexed like the other arrays, while changed_ids only holds
+		//		 the transforms that changed. This way, clearing the changes doesn't touch every transform.
+		utl::vector<u8> change_flags_array;
+		utl::vector<transform_id> changed_ids;
+		std::mutex changed_ids_mutex;
+
+		u32 slot_of(transform_id id) {
+			const id::id_type index{ id::index(id) };
+			assert(index < slots.size() && slots[index] != u32_invalid_id);
+			return slots[index];
+		}
+
+		void set_changed(transform_id id, u8 flags) {
+			const u32 slot{ slot_of(id) };
+			// NOTE: scripts that are updated in parallel may change the transforms of their own entities.
+			//		 Only the first change of a transform since clear_changes() needs to take the lock.
+			const u8 old_flags{ std::atomic_ref<u8>{ change_flags_array[slot] }.fetch_or(flags) };
+			if (!old_flags) {
+				std::lock_guard lock{ changed_ids_mutex };
+				changed_ids.emplace_back(id);
+			}
+		}
+
+		void pop_last_slot() {
+			rotations.pop_back();
+			positions.pop_back();
+			previous_rotations.pop_back();
+			previous_positions.pop_back();
+			scales.pop_back();
+			world.pop_back();
+			owners.pop_back();
+			change_flags_array.pop_back();
+		}
+
+		void move_slot(u32 from, u32 to) {
+			rotations[to] = rotations[from];
+			positions[to] = positions[from];
+			previous_rotations[to] = previous_rotations[from];
+			previous_positions[to] = previous_positions[from];
+			scales[to] = scales[from];
+			world[to] = world[from];
+			change_flags_array[to] = change_flags_array[from];
+			owners[to] = owners[from];
+			slots[id::index(owners[to])] = to;
+		}
+
+		void shrink_arrays() {
+			rotations.shrink_to_fit();
+			positions.shrink_to_fit();
+			previous_rotations.shrink_to_fit();
+			previous_positions.shrink_to_fit();
+			scales.shrink_to_fit();
+			world.shrink_to_fit();
+			owners.shrink_to_fit();
+			change_flags_array.shrink_to_fit();
+		}
+
+		bool compaction_slice(void*) {
+			return compact(compaction_slice_size);
+		}
+	} // anonymous namespace
+
 	component create(init_info info, game_entity::entity entity) {
 		assert(entity.is_valid());
-		const id::id_type entity_index{ id::index(entity.get_id()) };
+		const transform_id id{ entity.get_id() };
+		const id::id_type index{ id::index(id) };
+		// NOTE: transform ids are entity ids, so the index is new or the entity that used it before was removed
+		while (slots.size() <= index) slots.emplace_back(u32_invalid_id);
+		assert(slots[index] == u32_invalid_id);
 
-		if (positions.size() > entity_index) {
-			rotations[entity_index] = math::v4(info.rotation);
-			positions[entity_index] = math::v3(info.position);
-			scales[entity_index] = math::v3(info.scale);
-		}
-		else {
-			assert(positions.size() == entity_index);
-			rotations.emplace_back(info.rotation);
-			positions.emplace_back(info.position);
-			scales.emplace_back(info.scale);
+		// NOTE: holes are only filled by compaction, which keeps the slots of live transforms in order
+		slots[index] = (u32)positions.size();
+		rotations.emplace_back(info.rotation);
+		positions.emplace_back(info.position);
+		previous_rotations.emplace_back(info.rotation);
+		previous_positions.emplace_back(info.position);
+		scales.emplace_back(info.scale);
+		world.emplace_back();
+		owners.emplace_back(id);
+		change_flags_array.emplace_back(change_flags::none);
+
+		set_changed(id, change_flags::all);
+		return component{ id };
+	}
+
+	void create_many(const init_info* const infos, const game_entity::entity_id* const ids, u32 count) {
+		assert(infos && ids);
+		const u32 new_size{ (u32)positions.size() + count };
+		rotations.reserve(new_size);
+		positions.reserve(new_size);
+		previous_rotations.reserve(new_size);
+		previous_positions.reserve(new_size);
+		scales.reserve(new_size);
+		world.reserve(new_size);
+		owners.reserve(new_size);
+		change_flags_array.reserve(new_size);
+
+		for (u32 i{ 0 }; i < count; ++i) {
+			const transform_id id{ ids[i] };
+			const id::id_type index{ id::index(id) };
+			while (slots.size() <= index) slots.emplace_back(u32_invalid_id);
+			assert(slots[index] == u32_invalid_id);
+
+			slots[index] = (u32)positions.size();
+			rotations.emplace_back(infos[i].rotation);
+			positions.emplace_back(infos[i].position);
+			previous_rotations.emplace_back(infos[i].rotation);
+			previous_positions.emplace_back(infos[i].position);
+			scales.emplace_back(infos[i].scale);
+			world.emplace_back();
+			owners.emplace_back(id);
+			change_flags_array.emplace_back(change_flags::all);
 		}
 
-		return component{ transform_id{ entity.get_id() } };
+		// NOTE: the new transforms weren't in the change list before, so they're added in one go
+		std::lock_guard lock{ changed_ids_mutex };
+		changed_ids.reserve(changed_ids.size() + count);
+		for (u32 i{ 0 }; i < count; ++i) changed_ids.emplace_back(ids[i]);
 	}
 
-	void remove([[maybe_unused]] component c) {
+	void remove(component c) {
 		assert(c.is_valid());
+		const u32 slot{ slot_of(c.get_id()) };
+		change_flags_array[slot] = change_flags::none;
+		owners[slot] = transform_id{ id::invalid_id };
+		slots[id::index(c.get_id())] = u32_invalid_id;
+
+		++hole_count;
+		first_hole = std::min(first_hole, slot);
+		if (!compaction_pending) {
+			compaction_pending = true;
+			scheduler::add_task(scheduler::category::compaction, compaction_slice, nullptr);
+		}
+	}
+
+	bool compact(u32 max_moves) {
+		for (u32 moves{ 0 }; hole_count && moves < max_moves; ++moves) {
+			// holes at the end are dropped
+			if (!id::is_valid(owners.back())) {
+				pop_last_slot();
+				--hole_count;
+				continue;
+			}
+
+			while (id::is_valid(owners[first_hole])) ++first_hole;
+			move_slot((u32)owners.size() - 1, first_hole);
+			owners.back() = transform_id{ id::invalid_id };
+		}
+
+		if (hole_count) return false;
+
+		first_hole = u32_invalid_id;
+		compaction_pending = false;
+		// NOTE: only give memory back when a lot of it is unused, so that growing again doesn't reallocate every time
+		if (owners.capacity() > 2 * owners.size()) shrink_arrays();
+		return true;
+	}
+
+	u64 snapshot_size() {
+		return utl::vector_blob_size(rotations) + utl::vector_blob_size(positions) + utl::vector_blob_size(scales) +
+			utl::vector_blob_size(world) + utl::vector_blob_size(owners) + utl::vector_blob_size(slots) + 2 * sizeof(u32);
+	}
+
+	void save_snapshot(utl::blob_stream_writer& writer) {
+		writer.write_vector(rotations);
+		writer.write_vector(positions);
+		writer.write_vector(scales);
+		writer.write_vector(world);
+		writer.write_vector(owners);
+		writer.write_vector(slots);
+		writer.write(hole_count);
+		writer.write(first_hole);
+	}
+
+	void restore_snapshot(utl::blob_stream_reader& reader) {
+		reader.read_vector(rotations);
+		reader.read_vector(positions);
+		reader.read_vector(scales);
+		reader.read_vector(world);
+		reader.read_vector(owners);
+		reader.read_vector(slots);
+		hole_count = reader.read<u32>();
+		first_hole = reader.read<u32>();
+		save_previous_poses();
+
+		const u32 slot_count{ (u32)owners.size() };
+		change_flags_array.resize(slot_count);
+		changed_ids.clear();
+		for (u32 i{ 0 }; i < slot_count; ++i) {
+			const bool is_hole{ !id::is_valid(owners[i]) };
+			change_flags_array[i] = is_hole ? change_flags::none : change_flags::all;
+			if (!is_hole) changed_ids.emplace_back(owners[i]);
+		}
+
+		if (hole_count && !compaction_pending) {
+			compaction_pending = true;
+			scheduler::add_task(scheduler::category::compaction, compaction_slice, nullptr);
+		}
+	}
+
+	const utl::vector<transform_id>& changes() {
+		return changed_ids;
+	}
+
+	u8 get_change_flags(transform_id id) {
+		assert(id::is_valid(id));
+		return change_flags_array[slot_of(id)];
+	}
+
+	void clear_changes() {
+		journal::record_transform_changes();
+		for (const transform_id id : changed_ids) {
+			// NOTE: removed transforms already cleared their flags
+			const id::id_type index{ id::index(id) };
+			if (slots[index] != u32_invalid_id && owners[slots[index]] == id) {
+				change_flags_array[slots[index]] = change_flags::none;
+			}
+		}
+		changed_ids.clear();
+	}
+
+	void get_poses(const transform_id* const ids, math::v3* const positions_out, math::v4* const rotations_out, u32 count) {
+		assert(ids && positions_out && rotations_out);
+		for (u32 i{ 0 }; i < count; ++i) {
+			const u32 slot{ slot_of(ids[i]) };
+			positions_out[i] = positions[slot];
+			rotations_out[i] = rotations[slot];
+		}
+	}
+
+	void set_poses(const transform_id* const ids, const math::v3* const new_positions, const math::v4* const new_rotations, u32 count) {
+		assert(ids && new_positions && new_rotations);
+		for (u32 i{ 0 }; i < count; ++i) {
+			const u32 slot{ slot_of(ids[i]) };
+			positions[slot] = new_positions[i];
+			rotations[slot] = new_rotations[i];
+			set_changed(ids[i], change_flags::position | change_flags::rotation);
+		}
+	}
+
+	void save_previous_poses() {
+		previous_rotations.resize(rotations.size());
+		previous_positions.resize(positions.size());
+		memcpy(previous_rotations.data(), rotations.data(), rotations.size() * sizeof(math::v4));
+		memcpy(previous_positions.data(), positions.data(), positions.size() * sizeof(math::v3));
+	}
+
+	void update_world_matrices(u32 first, u32 last, f32 alpha) {
+		using namespace DirectX;
+		last = std::min(last, count());
+		if (first >= last) return;
+
+		const XMVECTOR one{ XMVectorReplicate(1.f) };
+		const XMVECTOR two{ XMVectorReplicate(2.f) };
+		const XMVECTOR zero{ XMVectorZero() };
+
+		// NOTE: compute 4 matrices at a time. The inputs of 4 transforms are transposed, so that each
+		//		 SIMD register holds the same component (e.g. rotation.x) of all 4 transforms.
+		for (u32 i{ first }; i < last; i += 4) {
+			u32 index[4];
+			for (u32 j{ 0 }; j < 4; ++j) {
+				// NOTE: repeat the last transform when less than 4 are left
+				index[j] = std::min(i + j, last - 1);
+			}
+
+			XMMATRIX q{ XMLoadFloat4(&rotations[index[0]]), XMLoadFloat4(&rotations[index[1]]),
+				XMLoadFloat4(&rotations[index[2]]), XMLoadFloat4(&rotations[index[3]]) };
+			XMMATRIX p{ XMLoadFloat3(&positions[index[0]]), XMLoadFloat3(&positions[index[1]]),
+				XMLoadFloat3(&positions[index[2]]), XMLoadFloat3(&positions[index[3]]) };
+			if (alpha < 1.f) {
+				for (u32 j{ 0 }; j < 4; ++j) {
+					// NOTE: q and -q are the same rotation. Blend with the one that's closer, so the shorter arc is taken.
+					XMVECTOR q0{ XMLoadFloat4(&previous_rotations[index[j]]) };
+					if (XMVectorGetX(XMVector4Dot(q0, q.r[j])) < 0.f) q0 = XMVectorNegate(q0);
+					q.r[j] = XMQuaternionNormalize(XMVectorLerp(q0, q.r[j], alpha));
+					p.r[j] = XMVectorLerp(XMLoadFloat3(&previous_positions[index[j]]), p.r[j], alpha);
+				}
+			}
+			q = XMMatrixTranspose(q);
+			p = XMMatrixTranspose(p);
+			const XMMATRIX s{ XMMatrixTranspose(XMMATRIX{
+				XMLoadFloat3(&scales[index[0]]), XMLoadFloat3(&scales[index[1]]),
+				XMLoadFloat3(&scales[index[2]]), XMLoadFloat3(&scales[index[3]]) }) };
+
+			const XMVECTOR x{ q.r[0] }, y{ q.r[1] }, z{ q.r[2] }, w{ q.r[3] };
+			const XMVECTOR xx{ XMVectorMultiply(x, x) }, yy{ XMVectorMultiply(y, y) }, zz{ XMVectorMultiply(z, z) };
+			const XMVECTOR xy{ XMVectorMultiply(x, y) }, xz{ XMVectorMultiply(x, z) }, yz{ XMVectorMultiply(y, z) };
+			const XMVECTOR xw{ XMVectorMultiply(x, w) }, yw{ XMVectorMultiply(y, w) }, zw{ XMVectorMultiply(z, w) };
+
+			// rotation matrix from quaternion, with each row multiplied by its scale factor
+			const XMMATRIX r0{ XMMatrixTranspose(XMMATRIX{
+				XMVectorMultiply(XMVectorNegativeMultiplySubtract(two, XMVectorAdd(yy, zz), one), s.r[0]),
+				XMVectorMultiply(XMVectorMultiply(two, XMVectorAdd(xy, zw)), s.r[0]),
+				XMVectorMultiply(XMVectorMultiply(two, XMVectorSubtract(xz, yw)), s.r[0]),
+				zero }) };
+			const XMMATRIX r1{ XMMatrixTranspose(XMMATRIX{
+				XMVectorMultiply(XMVectorMultiply(two, XMVectorSubtract(xy, zw)), s.r[1]),
+				XMVectorMultiply(XMVectorNegativeMultiplySubtract(two, XMVectorAdd(xx, zz), one), s.r[1]),
+				XMVectorMultiply(XMVectorMultiply(two, XMVectorAdd(yz, xw)), s.r[1]),
+				zero }) };
+			const XMMATRIX r2{ XMMatrixTranspose(XMMATRIX{
+				XMVectorMultiply(XMVectorMultiply(two, XMVectorAdd(xz, yw)), s.r[2]),
+				XMVectorMultiply(XMVectorMultiply(two, XMVectorSubtract(yz, xw)), s.r[2]),
+				XMVectorMultiply(XMVectorNegativeMultiplySubtract(two, XMVectorAdd(xx, yy), one), s.r[2]),
+				zero }) };
+			const XMMATRIX r3{ XMMatrixTranspose(XMMATRIX{ p.r[0], p.r[1], p.r[2], one }) };
+
+			const u32 n{ std::min(4u, last - i) };
+			for (u32 j{ 0 }; j < n; ++j) {
+				XMStoreFloat4x4A(&world[i + j], XMMATRIX{ r0.r[j], r1.r[j], r2.r[j], r3.r[j] });
+			}
+		}
+	}
+
+	void update_world_matrices(f32 alpha) {
+		update_world_matrices(0, count(), alpha);
+	}
+
+	const math::m4x4a* world_matrices() {
+		return world.data();
+	}
+
+	const transform_id* slot_owners() {
+		return owners.data();
+	}
+
+	const math::v3* slot_positions() {
+		return positions.data();
+	}
+
+	u32 slot(transform_id id) {
+		return slot_of(id);
+	}
+
+	u32 count() {
+		return (u32)positions.size();
 	}
 
 	math::v4 component::rotation() const {
 		assert(is_valid());
-		return rotations[id::index(_id)];
+		return rotations[slot_of(_id)];
 	}
 
 	math::v3 component::position() const {
 		assert(is_valid());
-		return positions[id::index(_id)];
+		return positions[slot_of(_id)];
 	}
 
 	math::v3 component::scale() const {
 		assert(is_valid());
-		return scales[id::index(_id)];
+		return scales[slot_of(_id)];
+	}
+
+	void component::set_rotation(math::v4 rotation) {
+		assert(is_valid());
+		rotations[slot_of(_id)] = rotation;
+		set_changed(_id, change_flags::rotation);
+	}
+
+	void component::set_position(math::v3 position) {
+		assert(is_valid());
+		positions[slot_of(_id)] = position;
+		set_changed(_id, change_flags::position);
+	}
+
+	void component::set_scale(math::v3 scale) {
+		assert(is_valid());
+		scales[slot_of(_id)] = scale;
+		set_changed(_id, change_flags::scale);
 	}
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "ComponentsCommon.h"
+#include "..\Utilities\IOStream.h"
 
 namespace primal::transform
 {
@@ -11,7 +12,59 @@ namespace primal::transform
 		f32 scale[3] { 1.f, 1.f, 1.f };
 	};
 
+	namespace change_flags {
+		enum flags : u8 {
+			none = 0x00,
+			rotation = 0x01,
+			position = 0x02,
+			scale = 0x04,
+
+			all = rotation | position | scale
+		};
+	}
+
 	component create(init_info info, game_entity::entity entity);
+	// Creates the transforms of 'count' new entities with one reservation for all of them
+	void create_many(const init_info* const infos, const game_entity::entity_id* const ids, u32 count);
 	void remove(component c);
 
+	// Returns the transforms that were created or changed since the last call to clear_changes().
+	// Each transform is listed once. Transforms that were removed after they changed stay in the list,
+	// so consumers should check whether their entity is still alive.
+	const utl::vector<transform_id>& changes();
+	u8 get_change_flags(transform_id id);
+	void clear_changes();
+
+	// Bulk access for systems that move many transforms at once, e.g. physics.
+	// set_poses() marks the transforms' positions and rotations as changed.
+	void get_poses(const transform_id* const ids, math::v3* const positions, math::v4* const rotations, u32 count);
+	void set_poses(const transform_id* const ids, const math::v3* const positions, const math::v4* const rotations, u32 count);
+
+	// Copies the current positions and rotations. Call this at the start of every simulation step.
+	void save_previous_poses();
+
+	// Computes world matrices (scale, then rotation, then translation) of transforms in slots [first, last).
+	// Separate ranges can be computed in parallel. World matrices are indexed by slot.
+	// Positions and rotations are blended from the poses saved by save_previous_poses() (alpha = 0)
+	// to the current poses (alpha = 1), so that rendering is smooth when frames fall between simulation steps.
+	void update_world_matrices(u32 first, u32 last, f32 alpha = 1.f);
+	void update_world_matrices(f32 alpha = 1.f);
+	const math::m4x4a* world_matrices();
+	// Returns the transform id of each slot. Slots of removed transforms that haven't been compacted yet are invalid.
+	const transform_id* slot_owners();
+	const math::v3* slot_positions();
+	u32 slot(transform_id id);
+	// Number of slots, including holes
+	u32 count();
+
+	// Fills at most 'max_moves' holes left by removed transforms and returns true when no holes are left.
+	// This runs as a scheduler task after transforms are removed, but it can also be called directly,
+	// e.g. after unloading a level. Slots of live transforms change, so don't call it during script updates.
+	bool compact(u32 max_moves);
+
+	// Snapshots (see snapshot::save()). All restored transforms are reported as changed.
+	[[nodiscard]] u64 snapshot_size();
+	void save_snapshot(utl::blob_stream_writer& writer);
+	void restore_snapshot(utl::blob_stream_reader& reader);
+
 }
\ No newline at end of file
@@ -3,6 +3,10 @@
 #include "..\Components\Entity.h"
 #include "..\Components\Transform.h"
 #include "..\Components\Script.h"
+#include "..\Components\Prefab.h"
+#include "..\Components\Tags.h"
+#include "..\Core\Scheduler.h"
+#include "Utilities/IOStream.h"
 
 #include "Graphics/Renderer.h"
 
@@ -10,6 +14,7 @@
 
 #include <fstream>
 #include <filesystem>
+#include <cfloat>
 #include <Windows.h>
 
 namespace primal::content {
@@ -21,10 +26,52 @@ namespace primal::content {
 			count
 		};
 
-		utl::vector<game_entity::entity> entities;
+		enum class cell_state : u32 {
+			unloaded,
+			queued,
+			loading,
+			loaded,
+			failed,		// the cell's records are corrupt. The cell is loaded again after it was unloaded.
+		};
+
+		struct world_cell {
+			s32 x;
+			s32 z;
+			u32 entity_count;
+			u64 offset;			// of the cell's block, from the first block
+			u32 size;
+			cell_state state{ cell_state::unloaded };
+			utl::vector<game_entity::entity_id> entities;
+			// NOTE: the block is only kept while the cell is loading
+			std::unique_ptr<u8[]> block;
+			const u8* at{ nullptr };
+			u32 read_count{ 0 };
+		};
+
+		// NOTE: instance records have entity type prefab index + 1
+		utl::vector<id::id_type> prefabs;
+		utl::vector<transform::init_info> instance_transforms;
+
+		utl::vector<world_cell> cells;
+		f32 cell_size{ 0.f };
+		u64 first_block{ 0 };
+		std::ifstream world_file;
+
+		streaming_settings settings{};
+		utl::vector<math::v3> focus_points;
+		utl::deque<u32> load_queue;
+		bool load_task_pending{ false };
+		constexpr u32 load_slice_size{ 64 }; // number of entities created per scheduler slice
+
 		transform::init_info transform_info{};
 		script::init_info script_info{};
 
+		u32 read_u32(const u8*& at) {
+			u32 value;
+			memcpy(&value, at, sizeof(u32)); at += sizeof(u32);
+			return value;
+		}
+
 		bool read_transform(const u8*& data, game_entity::entity_info& info) {
 			using namespace DirectX;
 			f32 rotation[3];
@@ -50,16 +97,11 @@ namespace primal::content {
 		bool read_script(const u8*& data, game_entity::entity_info& info) {
 			assert(!info.script);
 
-			const u32 name_length{ *data }; data += sizeof(u32);
+			const u32 name_length{ read_u32(data) };
 			if (!name_length) return false;
 
-			// NOTE: If a script name is longer than 255 characters then something is wrong.
-			//		 Probably with the binary writer.
-			assert(name_length < 256);
-
-			char script_name[256]{};
-			memcpy(&script_name[0], data, name_length); data += name_length;
-			script_name[name_length] = 0; // make the name a zero-terminated c-string
+			const std::string script_name{ (const char*)data, name_length }; data += name_length;
+			// NOTE: the script may have been renamed or removed since the game was saved, so it may not exist
 			script_info.script_creator = script::detail::get_script_creator(script::detail::string_hash()(script_name));
 
 			info.script = &script_info;
@@ -90,49 +132,283 @@ namespace primal::content {
 			return true;
 		}
 
-	} // anonymous namespace
-
-	bool load_game() {
-		// read game.bin and create the entities
-		std::unique_ptr<u8[]> game_data{};
-		u64 size{ 0 };
-		if (!read_file("game.bin", game_data, size)) return false;
-		assert(game_data.get());
-		const u8* at{ game_data.get() };
-		constexpr u32 su32{ sizeof(u32) };
-		const u32 num_entities{ *at }; at += su32;
-
-		if (!num_entities) return false;
-
-		for (u32 entity_index{ 0 }; entity_index < num_entities; ++entity_index) {
-			game_entity::entity_info info{};
-			const u32 entity_type{ *at }; at += su32;
-			const u32 num_components{ *at }; at += su32;
+		// Reads the components of an entity record. The entity type was read already.
+		// NOTE: all components are read, even after one failed (e.g. a script that isn't registered), so 'at' is at
+		//		 the next record afterwards and only this entity has to be skipped. Unknown component types can't be
+		//		 skipped, because their size isn't known, so 'corrupt' is set for them.
+		bool read_components(const u8*& at, game_entity::entity_info& info, bool& corrupt) {
+			const u32 num_components{ read_u32(at) };
+			corrupt = false;
 
 			if (!num_components) return false;
 
+			bool result{ true };
 			for (u32 component_index{ 0 }; component_index < num_components; ++component_index) {
-				const u32 component_type{ *at }; at += su32;
-				assert(component_type < component_type::count);
-				if (!component_readers[component_type](at, info)) return false;
+				const u32 component_type{ read_u32(at) };
+				if (component_type >= component_type::count) {
+					corrupt = true;
+					return false;
+				}
+				result &= component_readers[component_type](at, info);
 			}
 
-			assert(info.transform);
-			game_entity::entity entity{ game_entity::create(info) };
-			if (!entity.is_valid()) return false;
-			entities.emplace_back(entity);
+			return result && info.transform != nullptr;
+		}
+
+		// Distance on the xz plane from 'p' to the closest point of the cell, squared
+		f32 distance_sq(const world_cell& cell, math::v3 p) {
+			const f32 min_x{ cell.x * cell_size }, min_z{ cell.z * cell_size };
+			const f32 dx{ p.x < min_x ? min_x - p.x : (p.x > min_x + cell_size ? p.x - min_x - cell_size : 0.f) };
+			const f32 dz{ p.z < min_z ? min_z - p.z : (p.z > min_z + cell_size ? p.z - min_z - cell_size : 0.f) };
+			return dx * dx + dz * dz;
+		}
+
+		f32 focus_distance_sq(const world_cell& cell) {
+			// NOTE: without focus points every cell is loaded, like before streaming was added
+			if (focus_points.empty()) return 0.f;
+			f32 closest{ FLT_MAX };
+			for (const math::v3& p : focus_points) {
+				const f32 d{ distance_sq(cell, p) };
+				if (d < closest) closest = d;
+			}
+			return closest;
+		}
+
+		void unload_cell(world_cell& cell) {
+			// NOTE: the game may have removed some of the cell's entities already
+			utl::vector<game_entity::entity_id> alive{};
+			alive.reserve(cell.entities.size());
+			for (const game_entity::entity_id id : cell.entities) {
+				if (id::is_valid(id) && game_entity::is_alive(id)) alive.emplace_back(id);
+			}
+
+			if (!alive.empty()) game_entity::remove_many(alive.data(), (u32)alive.size());
+			cell.entities.clear();
+			cell.block.reset();
+			cell.at = nullptr;
+			cell.read_count = 0;
+			cell.state = cell_state::unloaded;
+		}
+
+		// Creates at most 'max_entities' entities of the queued cells, in the order in which they were queued.
+		// Returns true when no cells are left to load.
+		bool load_cells(u32 max_entities) {
+			while (!load_queue.empty()) {
+				world_cell& cell{ cells[load_queue.front()] };
+				// NOTE: cells that were unloaded before they finished loading are skipped
+				if (cell.state != cell_state::queued && cell.state != cell_state::loading) {
+					load_queue.pop_front();
+					continue;
+				}
+
+				if (cell.state == cell_state::queued) {
+					cell.block = std::make_unique<u8[]>(cell.size);
+					world_file.seekg(first_block + cell.offset);
+					if (!world_file.read((char*)cell.block.get(), cell.size)) {
+						assert(false);
+						world_file.clear();
+						cell.block.reset();
+						cell.state = cell_state::unloaded;
+						load_queue.pop_front();
+						continue;
+					}
+
+					cell.at = cell.block.get();
+					cell.entities.reserve(cell.entity_count);
+					cell.state = cell_state::loading;
+				}
+
+				bool failed{ false };
+				while (max_entities && cell.read_count < cell.entity_count) {
+					const u32 entity_type{ read_u32(cell.at) };
+					++cell.read_count;
+					--max_entities;
+					if (!entity_type) {
+						// NOTE: entities that fail to load keep their place with an invalid id, because names refer to entities by position
+						game_entity::entity_info info{};
+						bool corrupt;
+						const bool loaded{ read_components(cell.at, info, corrupt) };
+						if (corrupt) {
+							failed = true;
+							break;
+						}
+
+						cell.entities.emplace_back(loaded ? game_entity::create(info).get_id() : game_entity::entity_id{ id::invalid_id });
+						continue;
+					}
+
+					// instances only store their transform. Instances of the same prefab are stored
+					// next to each other, so they're created in one batch.
+					if (entity_type > prefabs.size()) {
+						failed = true;
+						break;
+					}
+					instance_transforms.clear();
+					while (true) {
+						game_entity::entity_info info{};
+						read_transform(cell.at, info);
+						instance_transforms.emplace_back(*info.transform);
+
+						if (!max_entities || cell.read_count == cell.entity_count) break;
+						u32 next_type;
+						memcpy(&next_type, cell.at, sizeof(u32));
+						if (next_type != entity_type) break;
+						cell.at += sizeof(u32);
+						++cell.read_count;
+						--max_entities;
+					}
+
+					const u32 first{ (u32)cell.entities.size() };
+					const u32 count{ (u32)instance_transforms.size() };
+					cell.entities.resize(first + count);
+					prefab::instantiate(prefabs[entity_type - 1], instance_transforms.data(), count, &cell.entities[first]);
+				}
+
+				if (failed) {
+					assert(false);
+					unload_cell(cell);
+					cell.state = cell_state::failed;
+					load_queue.pop_front();
+					continue;
+				}
+
+				if (cell.read_count < cell.entity_count) return false;
+
+				// names of the cell's entities, which refer to entities by their position in the cell
+				const u32 name_count{ read_u32(cell.at) };
+				for (u32 i{ 0 }; i < name_count; ++i) {
+					const u32 position{ read_u32(cell.at) };
+					const u32 length{ read_u32(cell.at) };
+					const std::string name{ (const char*)cell.at, length };
+					cell.at += length;
+					assert(position < cell.entities.size());
+					if (id::is_valid(cell.entities[position])) tags::set_name(cell.entities[position], name.c_str());
+				}
+
+				assert(cell.at == cell.block.get() + cell.size);
+				cell.block.reset();
+				cell.at = nullptr;
+				cell.state = cell_state::loaded;
+				load_queue.pop_front();
+			}
+
+			return true;
 		}
 
-		assert(at == game_data.get() + size);
+		bool load_slice(void*) {
+			if (!load_cells(load_slice_size)) return false;
+			load_task_pending = false;
+			return true;
+		}
+
+	} // anonymous namespace
+
+	bool load_game() {
+		world_file.open("game.bin", std::ios::in | std::ios::binary);
+		if (!world_file) return false;
+
+		// read the prefabs
+		u32 prefab_header[2]; // number of prefabs and size of their records
+		if (!world_file.read((char*)prefab_header, sizeof(prefab_header))) return false;
+		if (prefab_header[0]) {
+			std::unique_ptr<u8[]> prefab_data{ std::make_unique<u8[]>(prefab_header[1]) };
+			if (!world_file.read((char*)prefab_data.get(), prefab_header[1])) return false;
+			const u8* at{ prefab_data.get() };
+			for (u32 i{ 0 }; i < prefab_header[0]; ++i) {
+				game_entity::entity_info info{};
+				[[maybe_unused]] const u32 entity_type{ read_u32(at) };
+				assert(!entity_type);
+				bool corrupt;
+				if (!read_components(at, info, corrupt)) return false;
+				prefabs.emplace_back(prefab::create(info));
+			}
+			assert(at == prefab_data.get() + prefab_header[1]);
+		}
+
+		// read the cell table. The blocks are read when their cells are loaded.
+		constexpr u32 table_header_size{ sizeof(f32) + sizeof(u32) };
+		constexpr u32 cell_entry_size{ 2 * sizeof(s32) + sizeof(u32) + sizeof(u64) + sizeof(u32) };
+		u8 table_header[table_header_size];
+		if (!world_file.read((char*)table_header, table_header_size)) return false;
+		utl::blob_stream_reader header_reader{ table_header };
+		cell_size = header_reader.read<f32>();
+		const u32 cell_count{ header_reader.read<u32>() };
+		if (!cell_count || cell_size <= 0.f) return false;
+
+		std::unique_ptr<u8[]> table{ std::make_unique<u8[]>(cell_count * cell_entry_size) };
+		if (!world_file.read((char*)table.get(), cell_count * cell_entry_size)) return false;
+		first_block = (u64)world_file.tellg();
+
+		utl::blob_stream_reader reader{ table.get() };
+		cells.reserve(cell_count);
+		for (u32 i{ 0 }; i < cell_count; ++i) {
+			world_cell& cell{ cells.emplace_back() };
+			cell.x = reader.read<s32>();
+			cell.z = reader.read<s32>();
+			cell.entity_count = reader.read<u32>();
+			cell.offset = reader.read<u64>();
+			cell.size = reader.read<u32>();
+		}
+
+		// NOTE: the cells around the focus points are loaded right away, so the game doesn't start in an empty world
+		update_streaming();
+		load_cells(u32_invalid_id);
 		return true;
 	}
 
 	void unload_game() {
-		for (auto entity : entities) {
-			game_entity::remove(entity.get_id());
+		for (world_cell& cell : cells) {
+			if (cell.state != cell_state::unloaded) unload_cell(cell);
+		}
+
+		cells.clear();
+		load_queue.clear();
+		world_file.close();
+
+		for (const id::id_type id : prefabs) prefab::remove(id);
+		prefabs.clear();
+	}
+
+	void set_streaming_settings(const streaming_settings& new_settings) {
+		assert(new_settings.load_radius <= new_settings.unload_radius);
+		settings = new_settings;
+	}
+
+	void set_focus_points(const math::v3* const points, u32 count) {
+		assert(points || !count);
+		focus_points.resize(count);
+		if (count) memcpy(focus_points.data(), points, count * sizeof(math::v3));
+	}
+
+	void update_streaming() {
+		const f32 load_sq{ settings.load_radius * settings.load_radius };
+		const f32 unload_sq{ settings.unload_radius * settings.unload_radius };
+		for (u32 i{ 0 }; i < cells.size(); ++i) {
+			world_cell& cell{ cells[i] };
+			const f32 d{ focus_distance_sq(cell) };
+			if (cell.state == cell_state::unloaded) {
+				if (d <= load_sq) {
+					cell.state = cell_state::queued;
+					load_queue.push_back(i);
+				}
+			}
+			else if (d > unload_sq) {
+				unload_cell(cell);
+			}
+		}
+
+		if (!load_queue.empty() && !load_task_pending) {
+			load_task_pending = true;
+			scheduler::add_task(scheduler::category::assets, load_slice, nullptr);
 		}
 	}
 
+	u32 loaded_cell_count() {
+		u32 count{ 0 };
+		for (const world_cell& cell : cells) count += cell.state == cell_state::loaded ? 1 : 0;
+		return count;
+	}
+
 	bool load_engine_shaders(std::unique_ptr<u8[]>& shaders, u64& size) {
 		auto path = graphics::get_engine_shaders_path();
 		return read_file(path, shaders, size);
@@ -1,12 +1,17 @@
 #pragma once
 #include "CommonHeaders.h"
+#include "..\EngineAPI\Streaming.h"
 
 #if !defined(SHIPPING)
 
 namespace primal::content {
+	// Reads the cell table of the game world and loads the cells around the focus points.
 	bool load_game();
 	void unload_game();
 
+	// Requests loading and unloading of cells (see EngineAPI\Streaming.h). Unloading removes the entities of the cell at once.
+	void update_streaming();
+
 	bool load_engine_shaders(std::unique_ptr<u8[]>& shaders, u64& size);
 }
 
@@ -2,10 +2,18 @@
 
 #include "..\Content\ContentLoader.h"
 #include "..\Components\Script.h"
+#include "..\Components\Transform.h"
+#include "..\Components\RigidBody.h"
+#include "..\Components\EntityCommands.h"
+#include "..\Components\EventBus.h"
+#include "..\Spatial\Spatial.h"
+#include "JobSystem.h"
+#include "Scheduler.h"
+#include "GameLoop.h"
+#include "FramePipeline.h"
 #include "..\Platform\PlatformTypes.h"
 #include "..\Platform\Platform.h"
 #include "..\Graphics\Renderer.h"
-#include <thread>
 
 using namespace primal;
 
@@ -33,9 +41,34 @@ namespace {
 
         return DefWindowProc(hwnd, msg, wparam, lparam);
     }
+
+    void simulate_step(f32 dt) {
+        primal::transform::save_previous_poses();
+        // NOTE: scripts get dt in milliseconds, while physics works in seconds
+        primal::script::update(dt * 1000.f);
+        // NOTE: event handlers may record entity commands, which are applied right after
+        primal::events::dispatch();
+        primal::game_entity::flush_commands();
+        primal::rigid_body::update(dt);
+        primal::spatial::update();
+        // NOTE: transform changes are collected per step, including those made between steps (e.g. by streaming).
+        //       Consumers process them before the end of the step.
+        primal::transform::clear_changes();
+    }
+
+    // NOTE: runs on the render thread in pipelined mode
+    void render_frame(const frame_pipeline::frame_state&, void*) {
+        if (game_window.surface.is_valid()) {
+            game_window.surface.render();
+        }
+    }
 } // anonymous namespace
 
 bool engine_initialize() {
+    if (!jobs::initialize()) return false;
+    script::set_parallel_update(true);
+    frame_pipeline::initialize(render_frame, nullptr, true);
+
     if (!primal::content::load_game()) return false;
 
     platform::window_init_info info{
@@ -49,13 +82,30 @@ bool engine_initialize() {
 }
 
 void engine_update() {
-    primal::script::update(10.f);
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const u32 step_count{ game_loop::begin_frame() };
+    // NOTE: cells of the world are loaded in scheduler slices, so request them before the scheduler runs
+    primal::content::update_streaming();
+    // NOTE: deferrable work (e.g. low priority scripts) runs within its per-frame budget
+    primal::scheduler::run();
+
+    for (u32 i{ 0 }; i < step_count; ++i) {
+        simulate_step(game_loop::get_settings().fixed_dt);
+    }
+
+    const f32 alpha{ game_loop::interpolation_alpha() };
+    jobs::parallel_for(transform::count(), 4096, [alpha](u32 first, u32 last) {
+        transform::update_world_matrices(first, last, alpha);
+        });
+    // NOTE: in pipelined mode, the next frame is simulated while this one is rendered
+    frame_pipeline::submit_frame();
+    game_loop::wait_for_next_frame();
 }
 
 void engine_shutdown() {
+    frame_pipeline::shutdown();
     platform::remove_window(game_window.window.get_id());
     primal::content::unload_game();
+    jobs::shutdown();
 }
 
 #endif // !defined(SHIPPING)
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "FramePipeline.h"
+#include "..\Components\Entity.h"
+#include "..\Components\Transform.h"
+#include "..\Spatial\Spatial.h"
+
+#include <condition_variable>
+#include <thread>
+
+namespace primal::frame_pipeline {
+
+	// anonymous namespace
+	namespace {
+		frame_state frame_states[2];
+		u32 write_index{ 0 };
+		u64 frame_number{ 0 };
+
+		render_func render{ nullptr };
+		void* render_context{ nullptr };
+		bool pipelined{ false };
+
+		spatial::sphere view_bounds{};
+		bool has_view_bounds{ false };
+		utl::vector<game_entity::entity_id> visible;
+
+		std::thread render_thread;
+		std::mutex mutex;
+		std::condition_variable frame_cv;
+		u32 pending_index{ u32_invalid_id };	// frame state that was submitted but not taken by the render thread yet
+		bool quit{ false };
+
+		void render_main() {
+			while (true) {
+				u32 index;
+				{
+					std::unique_lock lock{ mutex };
+					frame_cv.wait(lock, [] { return quit || pending_index != u32_invalid_id; });
+					if (pending_index == u32_invalid_id) return;
+
+					index = pending_index;
+					pending_index = u32_invalid_id;
+				}
+				// NOTE: the simulation thread may fill the other frame state now
+				frame_cv.notify_all();
+				render(frame_states[index], render_context);
+			}
+		}
+
+		void extract(frame_state& state) {
+			state.entities.clear();
+			state.world_matrices.clear();
+			state.frame_number = frame_number++;
+
+			const math::m4x4a* const world{ transform::world_matrices() };
+			if (has_view_bounds) {
+				visible.clear();
+				spatial::query(view_bounds, visible);
+				state.entities.reserve(visible.size());
+				state.world_matrices.reserve(visible.size());
+				for (const game_entity::entity_id id : visible) {
+					const u32 slot{ transform::slot(game_entity::entity{ id }.transform().get_id()) };
+					state.entities.emplace_back(id);
+					state.world_matrices.emplace_back(world[slot]);
+				}
+				return;
+			}
+
+			// NOTE: holes left by removed transforms have invalid owners and are skipped
+			const u32 count{ transform::count() };
+			const transform::transform_id* const owners{ transform::slot_owners() };
+			state.entities.reserve(count);
+			state.world_matrices.reserve(count);
+			for (u32 i{ 0 }; i < count; ++i) {
+				if (!id::is_valid(owners[i])) continue;
+				state.entities.emplace_back(game_entity::entity_id{ (id::id_type)owners[i] });
+				state.world_matrices.emplace_back(world[i]);
+			}
+		}
+	} // anonymous namespace
+
+	void initialize(render_func func, void* context, bool pipelined_mode) {
+		assert(func && !render_thread.joinable());
+		render = func;
+		render_context = context;
+		pipelined = pipelined_mode;
+		if (pipelined) {
+			quit = false;
+			render_thread = std::thread{ render_main };
+		}
+	}
+
+	void shutdown() {
+		if (render_thread.joinable()) {
+			{
+				std::lock_guard lock{ mutex };
+				quit = true;
+			}
+			frame_cv.notify_all();
+			render_thread.join();
+		}
+
+		for (frame_state& state : frame_states) {
+			state.entities.clear();
+			state.world_matrices.clear();
+		}
+		write_index = 0;
+		frame_number = 0;
+		pipelined = false;
+		render = nullptr;
+	}
+
+	bool is_pipelined() {
+		return pipelined;
+	}
+
+	void set_view_bounds(const spatial::sphere& view) {
+		view_bounds = view;
+		has_view_bounds = true;
+	}
+
+	void clear_view_bounds() {
+		has_view_bounds = false;
+	}
+
+	void submit_frame() {
+		assert(render);
+		if (!pipelined) {
+			extract(frame_states[0]);
+			render(frame_states[0], render_context);
+			return;
+		}
+
+		// NOTE: once the render thread took the previous frame, it only reads that frame state,
+		//		 because it renders one frame at a time. The other frame state is free to be filled.
+		{
+			std::unique_lock lock{ mutex };
+			frame_cv.wait(lock, [] { return pending_index == u32_invalid_id; });
+		}
+
+		extract(frame_states[write_index]);
+
+		{
+			std::lock_guard lock{ mutex };
+			pending_index = write_index;
+		}
+		frame_cv.notify_all();
+		write_index ^= 1;
+	}
+}
\ No newline at end of file
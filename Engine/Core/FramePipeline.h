@@ -0,0 +1,34 @@
+#pragma once
+#include "CommonHeaders.h"
+#include "..\Spatial\SpatialCommon.h"
+
+namespace primal::frame_pipeline {
+
+	// Rendering state that is copied out of the simulation at the end of a frame, so that
+	// the renderer doesn't read transforms while the next frame is being simulated.
+	struct frame_state {
+		utl::vector<game_entity::entity_id> entities;
+		utl::vector<math::m4x4a> world_matrices;	// world matrix of each entity
+		u64 frame_number{ 0 };
+	};
+
+	using render_func = void(*)(const frame_state& state, void* context);
+
+	// In pipelined mode, a render thread renders frame N while the calling thread simulates frame N+1.
+	// There are two frame states: the render thread reads one while the other is filled. Otherwise,
+	// frames are rendered on the thread that submits them.
+	void initialize(render_func func, void* context, bool pipelined);
+	// Renders the last submitted frame if it hasn't been rendered yet, then stops the render thread.
+	void shutdown();
+	[[nodiscard]] bool is_pipelined();
+
+	// Only entities that overlap the view bounds are extracted, e.g. the bounds of the camera frustum.
+	// NOTE: this only finds entities in the spatial index. Without view bounds, all entities with a transform are extracted.
+	void set_view_bounds(const spatial::sphere& view);
+	void clear_view_bounds();
+
+	// Copies the world matrices computed by transform::update_world_matrices() into a frame state and
+	// renders it. In pipelined mode, this waits until the render thread has taken the previous frame,
+	// so the simulation is never more than one frame ahead of rendering.
+	void submit_frame();
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "GameLoop.h"
+
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN64
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif // _WIN64
+
+namespace primal::game_loop {
+
+	// anonymous namespace
+	namespace {
+		using clock = std::chrono::steady_clock;
+
+		settings loop_settings{};
+		clock::time_point frame_start{};
+		clock::duration accumulator{ 0 };
+		bool is_first_frame{ true };
+
+		// NOTE: the rest of the wait, shorter than this, is spent yielding, because sleeps may wake up a bit late
+		constexpr std::chrono::microseconds sleep_margin{ 1000 };
+
+		clock::duration to_duration(f32 seconds) {
+			return std::chrono::duration_cast<clock::duration>(std::chrono::duration<f32>(seconds));
+		}
+
+#ifdef _WIN64
+		// NOTE: Sleep() and std::this_thread::sleep_for() round up to the timer period, which is about 15.6 ms
+		//		 by default. That's longer than a whole frame at 120 Hz. A high resolution waitable timer wakes up
+		//		 within about half a millisecond. Where it's not available (before Windows 10 1803),
+		//		 the timer period is lowered to 1 ms instead, while the game loop is used.
+		struct wait_timer {
+			HANDLE handle{ CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS) };
+			bool raised_timer_resolution{ false };
+
+			wait_timer() {
+				if (!handle) raised_timer_resolution = timeBeginPeriod(1) == TIMERR_NOERROR;
+			}
+
+			~wait_timer() {
+				if (handle) CloseHandle(handle);
+				if (raised_timer_resolution) timeEndPeriod(1);
+			}
+		};
+#endif // _WIN64
+
+		void sleep(clock::duration duration) {
+#ifdef _WIN64
+			static wait_timer timer{};
+			if (timer.handle) {
+				// NOTE: negative due times are relative, in units of 100 ns
+				LARGE_INTEGER due_time{};
+				due_time.QuadPart = -(LONGLONG)(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 100);
+				if (SetWaitableTimerEx(timer.handle, &due_time, 0, nullptr, nullptr, nullptr, 0)) {
+					WaitForSingleObject(timer.handle, INFINITE);
+					return;
+				}
+			}
+#endif // _WIN64
+			std::this_thread::sleep_for(duration);
+		}
+	} // anonymous namespace
+
+	void set_settings(const settings& s) {
+		assert(s.fixed_dt > 0.f && s.max_steps_per_frame && s.target_frame_time >= 0.f);
+		loop_settings = s;
+	}
+
+	const settings& get_settings() {
+		return loop_settings;
+	}
+
+	u32 begin_frame() {
+		const clock::time_point now{ clock::now() };
+		// NOTE: the first frame doesn't simulate, because there is no time before it. This way,
+		//		 the time spent loading the game doesn't have to be caught up.
+		if (is_first_frame) {
+			is_first_frame = false;
+			frame_start = now;
+			return 0;
+		}
+
+		accumulator += now - frame_start;
+		frame_start = now;
+
+		const clock::duration dt{ to_duration(loop_settings.fixed_dt) };
+		u32 steps{ (u32)(accumulator / dt) };
+		if (steps > loop_settings.max_steps_per_frame) {
+			steps = loop_settings.max_steps_per_frame;
+			accumulator = clock::duration{ 0 };
+		}
+		else {
+			accumulator -= steps * dt;
+		}
+
+		return steps;
+	}
+
+	f32 interpolation_alpha() {
+		return (f32)accumulator.count() / (f32)to_duration(loop_settings.fixed_dt).count();
+	}
+
+	void wait_for_next_frame() {
+		if (loop_settings.target_frame_time <= 0.f) return;
+
+		const clock::time_point frame_end{ frame_start + to_duration(loop_settings.target_frame_time) };
+		const clock::time_point now{ clock::now() };
+		if (frame_end - now > sleep_margin) {
+			sleep(frame_end - now - sleep_margin);
+		}
+
+		while (clock::now() < frame_end) {
+			std::this_thread::yield();
+		}
+	}
+}
\ No newline at end of file
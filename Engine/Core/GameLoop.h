@@ -0,0 +1,28 @@
+#pragma once
+#include "CommonHeaders.h"
+
+namespace primal::game_loop {
+
+	// The simulation advances in fixed steps, independent of the frame rate. Each frame adds the real time
+	// that passed to an accumulator, and one step is simulated for every fixed_dt in the accumulator.
+	// Rendering blends the last two simulated states with interpolation_alpha().
+	struct settings {
+		f32 fixed_dt{ 1.f / 60.f };			// seconds
+		// NOTE: when the simulation can't keep up, the time beyond this many steps is dropped,
+		//		 so that slow frames don't make the next frames even slower.
+		u32 max_steps_per_frame{ 5 };
+		f32 target_frame_time{ 1.f / 120.f };	// seconds, 0 doesn't limit the frame rate
+	};
+
+	void set_settings(const settings& s);
+	[[nodiscard]] const settings& get_settings();
+
+	// Adds the time since the last call to the accumulator and returns the number of fixed steps to simulate.
+	[[nodiscard]] u32 begin_frame();
+	// Fraction of a step that is left in the accumulator after the steps of this frame, in [0, 1).
+	[[nodiscard]] f32 interpolation_alpha();
+	// Waits until target_frame_time has passed since the last call of begin_frame().
+	// NOTE: sleeps on a high resolution timer while there is enough time left, and yields for the last
+	//		 millisecond, because sleeps may wake up a bit later than requested.
+	void wait_for_next_frame();
+}
\ No newline at end of file
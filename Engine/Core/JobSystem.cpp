@@ -0,0 +1,132 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+namespace primal::jobs {
+
+	// anonymous namespace
+	namespace {
+		struct batch {
+			range_func func;
+			void* context;
+			u32 count;
+			u32 range_size;
+			std::atomic<u32> next{ 0 };
+		};
+
+		utl::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable work_cv;
+		std::condition_variable done_cv;
+		batch* current_batch{ nullptr };
+		u64 batch_generation{ 0 };
+		u32 busy_workers{ 0 };
+		bool quit{ false };
+
+		// serializes calls to parallel_for()
+		std::mutex parallel_for_mutex;
+		// NOTE: set on the worker threads and on the thread that runs a batch. Nested calls to parallel_for()
+		//		 from these threads run inline, because they would wait for themselves otherwise.
+		thread_local bool in_parallel_for{ false };
+
+		void run_ranges(batch& b) {
+			while (true) {
+				const u32 first{ b.next.fetch_add(b.range_size) };
+				if (first >= b.count) break;
+				b.func(b.context, first, std::min(b.count, first + b.range_size));
+			}
+		}
+
+		void worker_main() {
+			in_parallel_for = true;
+			u64 seen_generation{ 0 };
+			while (true) {
+				batch* b{ nullptr };
+				{
+					std::unique_lock lock{ mutex };
+					work_cv.wait(lock, [&] { return quit || batch_generation != seen_generation; });
+					if (quit) return;
+
+					seen_generation = batch_generation;
+					// NOTE: the batch may already be finished if this thread woke up late
+					if (!current_batch) continue;
+					b = current_batch;
+					++busy_workers;
+				}
+
+				run_ranges(*b);
+
+				{
+					std::lock_guard lock{ mutex };
+					--busy_workers;
+				}
+				done_cv.notify_one();
+			}
+		}
+	} // anonymous namespace
+
+	bool initialize(u32 thread_count) {
+		assert(workers.empty());
+		if (!thread_count) {
+			const u32 hardware_threads{ std::thread::hardware_concurrency() };
+			thread_count = hardware_threads > 1 ? hardware_threads - 1 : 0;
+		}
+
+		quit = false;
+		workers.reserve(thread_count);
+		for (u32 i{ 0 }; i < thread_count; ++i) {
+			workers.emplace_back(worker_main);
+		}
+
+		return true;
+	}
+
+	void shutdown() {
+		{
+			std::lock_guard lock{ mutex };
+			quit = true;
+		}
+		work_cv.notify_all();
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		workers.clear();
+	}
+
+	u32 worker_count() {
+		return (u32)workers.size();
+	}
+
+	void parallel_for(u32 count, u32 range_size, range_func func, void* context) {
+		assert(func && range_size);
+		if (!count) return;
+
+		batch b{ func, context, count, range_size };
+		if (workers.empty() || count <= range_size || in_parallel_for) {
+			run_ranges(b);
+			return;
+		}
+
+		std::lock_guard call_lock{ parallel_for_mutex };
+		{
+			std::lock_guard lock{ mutex };
+			current_batch = &b;
+			++batch_generation;
+		}
+		work_cv.notify_all();
+
+		in_parallel_for = true;
+		run_ranges(b);
+		in_parallel_for = false;
+
+		// NOTE: all ranges are taken when the calling thread runs out of work, but some may still be running.
+		//		 Wait for the workers to let go of the batch, because it lives on this thread's stack.
+		std::unique_lock lock{ mutex };
+		current_batch = nullptr;
+		done_cv.wait(lock, [] { return busy_workers == 0; });
+	}
+}
\ No newline at end of file
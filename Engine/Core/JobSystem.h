@@ -0,0 +1,25 @@
+#pragma once
+#include "CommonHeaders.h"
+
+namespace primal::jobs {
+
+	using range_func = void(*)(void* context, u32 first, u32 last);
+
+	// Starts 'thread_count' worker threads. If 'thread_count' is 0, one worker is started
+	// for each hardware thread, except for the calling thread.
+	bool initialize(u32 thread_count = 0);
+	void shutdown();
+	u32 worker_count();
+
+	// Splits [0, count) into ranges of at most 'range_size' and calls func(context, first, last) for each range
+	// on the worker threads and the calling thread. Returns when all ranges are done.
+	// NOTE: runs everything on the calling thread if there are no workers. Calls from different threads are serialized.
+	//		 Nested calls, i.e. from inside 'func', run everything on the calling thread as well.
+	void parallel_for(u32 count, u32 range_size, range_func func, void* context);
+
+	template<typename F> void parallel_for(u32 count, u32 range_size, F&& func) {
+		parallel_for(count, range_size, [](void* context, u32 first, u32 last) {
+			(*static_cast<std::remove_reference_t<F>*>(context))(first, last);
+			}, (void*)std::addressof(func));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "Scheduler.h"
+
+#include <chrono>
+
+namespace primal::scheduler {
+
+	// anonymous namespace
+	namespace {
+		using clock = std::chrono::steady_clock;
+
+		struct task {
+			slice_func func;
+			void* context;
+		};
+
+		constexpr u32 category_count{ (u32)category::count };
+
+		utl::deque<task> tasks[category_count];
+		category_stats stats[category_count]{ { 1000 }, { 500 }, { 500 }, { 200 } };
+		u32 frame_budget{ 2000 };
+
+		// NOTE: tasks that are added from other threads wait here until the next call of run()
+		utl::vector<std::pair<category, task>> new_tasks;
+		std::mutex new_tasks_mutex;
+
+		u32 elapsed_us(clock::time_point start) {
+			return (u32)std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+		}
+	} // anonymous namespace
+
+	void add_task(category c, slice_func func, void* context) {
+		assert(c < category::count && func);
+		std::lock_guard lock{ new_tasks_mutex };
+		new_tasks.emplace_back(c, task{ func, context });
+	}
+
+	void set_frame_budget(u32 microseconds) {
+		frame_budget = microseconds;
+	}
+
+	void set_budget(category c, u32 microseconds) {
+		assert(c < category::count);
+		stats[(u32)c].budget = microseconds;
+	}
+
+	category_stats get_stats(category c) {
+		assert(c < category::count);
+		return stats[(u32)c];
+	}
+
+	void run() {
+		{
+			std::lock_guard lock{ new_tasks_mutex };
+			for (const auto& [c, t] : new_tasks) {
+				tasks[(u32)c].push_back(t);
+			}
+			new_tasks.clear();
+		}
+
+		for (category_stats& s : stats) {
+			s.used = 0;
+			s.slice_count = 0;
+		}
+
+		const clock::time_point frame_start{ clock::now() };
+		bool ran_slice{ true };
+		// NOTE: go round-robin over the categories, one slice at a time, so that a category with
+		//		 long slices can't use up the frame budget before the others get a turn.
+		while (ran_slice) {
+			ran_slice = false;
+			for (u32 i{ 0 }; i < category_count; ++i) {
+				category_stats& s{ stats[i] };
+				utl::deque<task>& queue{ tasks[i] };
+				if (queue.empty()) continue;
+				if (s.slice_count && (s.used >= s.budget || elapsed_us(frame_start) >= frame_budget)) continue;
+
+				const task t{ queue.front() };
+				queue.pop_front();
+
+				const clock::time_point slice_start{ clock::now() };
+				const bool finished{ t.func(t.context) };
+				s.used += elapsed_us(slice_start);
+				++s.slice_count;
+				ran_slice = true;
+
+				// unfinished tasks go to the back of their queue, so tasks of the same category take turns
+				if (!finished) queue.push_back(t);
+			}
+		}
+
+		for (u32 i{ 0 }; i < category_count; ++i) {
+			stats[i].task_count = (u32)tasks[i].size();
+		}
+	}
+}
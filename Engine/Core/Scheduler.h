@@ -0,0 +1,39 @@
+#pragma once
+#include "CommonHeaders.h"
+
+namespace primal::scheduler {
+
+	// Deferrable work is grouped into categories, which each have their own budget per frame.
+	enum class category : u32 {
+		scripts,
+		assets,
+		spatial,
+		compaction,
+
+		count
+	};
+
+	// Runs one slice of a task and returns true when the task is finished.
+	// A task that isn't finished yet is resumed with its next slice, in this frame or in a later one.
+	using slice_func = bool(*)(void* context);
+
+	// Adds a task that is run slice by slice until it's finished. Can be called from any thread.
+	void add_task(category c, slice_func func, void* context);
+
+	// Budgets are in microseconds. The frame budget limits all categories together.
+	void set_frame_budget(u32 microseconds);
+	void set_budget(category c, u32 microseconds);
+
+	struct category_stats {
+		u32 budget{ 0 };		// microseconds
+		u32 used{ 0 };			// microseconds spent in the last call of run()
+		u32 slice_count{ 0 };	// number of slices run in the last call of run()
+		u32 task_count{ 0 };	// number of tasks that aren't finished yet
+	};
+
+	[[nodiscard]] category_stats get_stats(category c);
+
+	// Runs task slices until the budget of each category or the frame budget is used up.
+	// NOTE: each category with pending tasks runs at least one slice per call, so no category starves.
+	void run();
+}
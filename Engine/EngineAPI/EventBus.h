@@ -0,0 +1,50 @@
+#pragma once
+#include"..\Components\ComponentsCommon.h"
+
+namespace primal::events {
+
+	// Events are small structs that are copied with memcpy. Posting is lock-free: each thread appends to
+	// its own buffer, so scripts can post while they are updated in parallel. Events are delivered once per
+	// simulation step, after the scripts were updated, grouped by type and sorted by recipient, and each subscriber
+	// of a type gets all events of that type in one call. Events for removed recipients are dropped.
+	// NOTE: events that are posted while events are being delivered are delivered in the next step.
+	template<typename T>
+	using handler = void(*)(const game_entity::entity_id* const recipients, const T* const events, u32 count, void* context);
+
+	namespace detail {
+		// NOTE: handlers are stored without their event type. A function pointer may be cast to another function
+		//		 pointer type and back, but not called through it, so each handler is called by the invoker of its type.
+		using erased_handler = void(*)();
+		using invoker = void(*)(erased_handler func, const game_entity::entity_id* const recipients, const void* const events, u32 count, void* context);
+
+		template<typename T>
+		void invoke(erased_handler func, const game_entity::entity_id* const recipients, const void* const events, u32 count, void* context) {
+			reinterpret_cast<handler<T>>(func)(recipients, static_cast<const T*>(events), count, context);
+		}
+
+		u32 register_event_type(u32 size, u32 alignment);
+		void post(u32 type, game_entity::entity_id recipient, const void* const event);
+		void subscribe(u32 type, erased_handler func, invoker invoke, void* context);
+		void unsubscribe(u32 type, erased_handler func, void* context);
+
+		template<typename T> u32 event_type() {
+			static_assert(std::is_trivially_copyable_v<T>, "Events should be trivially copyable.");
+			static const u32 type{ register_event_type(sizeof(T), alignof(T)) };
+			return type;
+		}
+	}
+
+	// Sends 'event' to 'recipient'. Use an invalid id for events that aren't meant for one entity.
+	template<typename T> void post(game_entity::entity_id recipient, const T& event) {
+		detail::post(detail::event_type<T>(), recipient, &event);
+	}
+
+	// Subscribers of a type are called in the order in which they subscribed.
+	template<typename T> void subscribe(handler<T> func, void* context = nullptr) {
+		detail::subscribe(detail::event_type<T>(), reinterpret_cast<detail::erased_handler>(func), &detail::invoke<T>, context);
+	}
+
+	template<typename T> void unsubscribe(handler<T> func, void* context = nullptr) {
+		detail::unsubscribe(detail::event_type<T>(), reinterpret_cast<detail::erased_handler>(func), context);
+	}
+}
\ No newline at end of file
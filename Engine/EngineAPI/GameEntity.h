@@ -2,6 +2,7 @@
 #include "..\Components\ComponentsCommon.h"
 #include "ScriptComponent.h"
 #include "TransformComponent.h"
+#include "RigidBodyComponent.h"
 
 namespace primal {
 	namespace game_entity {
@@ -17,6 +18,7 @@ namespace primal {
 
 			transform::component transform() const;
 			script::component script() const;
+			rigid_body::component rigid_body() const;
 
 		private:
 			entity_id _id;
@@ -24,32 +26,136 @@ namespace primal {
 	}  // namespace game_entity
 
 	namespace script {
+		// Declares what a script type touches in update(). Script types that only read and write
+		// the components of their own entity can be updated in parallel.
+		// A script type declares it by hiding entity_script::access, e.g.:
+		//		static constexpr primal::script::update_access access{ primal::script::update_access::own_entity };
+		enum class update_access : u32 {
+			shared,
+			own_entity,
+		};
+
+		// Low priority scripts are updated in time slices by the frame scheduler. They may be updated in a
+		// later frame than normal scripts, in which case the dt passed to update() covers all frames since.
+		// NOTE: tick_interval doesn't apply to low priority scripts.
+		enum class update_priority : u32 {
+			normal,
+			low,
+		};
+
 		class entity_script : public game_entity::entity {
 		public:
+			static constexpr update_access access{ update_access::shared };
+			static constexpr update_priority priority{ update_priority::normal };
+			// Number of frames between two updates of scripts of this type. Script types that don't need
+			// to run every frame can hide this. The dt passed to update() is the time since their last update.
+			static constexpr u32 tick_interval{ 1 };
+
 			virtual ~entity_script() = default;
 			virtual void begin_play() {}
 			virtual void update(float) {}
 
+			// Scripts with state that should be kept in world snapshots override these. save_state() writes
+			// state_size() bytes, which are passed to load_state() of a new script when the snapshot is restored.
+			virtual u32 state_size() const { return 0; }
+			virtual void save_state(u8* const) const {}
+			virtual void load_state(const u8* const, u32) {}
+
 		protected:
 			constexpr explicit entity_script(game_entity::entity entity)
 				: game_entity::entity{ entity.get_id() } {}
 		};
 
 		namespace detail {
-			using script_ptr = std::unique_ptr<entity_script>;
-			using script_creator = script_ptr(*)(game_entity::entity entity);
+			// Type-erased storage for all scripts of one type. Scripts of the same type are stored contiguously
+			// and updated in one loop, so their update() calls can be devirtualized and inlined.
+			class script_pool_base {
+			public:
+				virtual ~script_pool_base() = default;
+
+				// Constructs a script at the end of the pool and returns it
+				virtual entity_script& create(game_entity::entity entity) = 0;
+				// Destroys the script at 'index' and moves the last script in its place
+				virtual void remove(u32 index) = 0;
+				// Calls update() for scripts with index in [first, last)
+				virtual void update(u32 first, u32 last, float dt) = 0;
+				// Calls update(dts[i]) for the scripts at indices[i], i in [0, count)
+				virtual void update(const u32* const indices, const float* const dts, u32 count) = 0;
+				// Exchanges the scripts at 'a' and 'b'
+				virtual void swap(u32 a, u32 b) = 0;
+				[[nodiscard]] virtual entity_script& get(u32 index) = 0;
+				[[nodiscard]] virtual u32 size() const = 0;
+				[[nodiscard]] virtual update_access access() const = 0;
+				[[nodiscard]] virtual u32 tick_interval() const = 0;
+				[[nodiscard]] virtual update_priority priority() const = 0;
+			};
+
+			// NOTE: scripts are relocated with memcpy when the pool grows or when a script is removed,
+			//		 the same way utl::vector moves its items.
+			template<class script_class>
+			class script_pool final : public script_pool_base {
+			public:
+				entity_script& create(game_entity::entity entity) override {
+					assert(entity.is_valid());
+					return _scripts.emplace_back(entity);
+				}
+
+				void remove(u32 index) override {
+					utl::erase_unordered(_scripts, index);
+				}
+
+				void update(u32 first, u32 last, float dt) override {
+					assert(first <= last && last <= _scripts.size());
+					script_class* const scripts{ _scripts.data() };
+					for (u32 i{ first }; i < last; ++i) {
+						// NOTE: qualified call, so there's no virtual dispatch per script
+						scripts[i].script_class::update(dt);
+					}
+				}
+
+				void update(const u32* const indices, const float* const dts, u32 count) override {
+					script_class* const scripts{ _scripts.data() };
+					for (u32 i{ 0 }; i < count; ++i) {
+						assert(indices[i] < _scripts.size());
+						scripts[indices[i]].script_class::update(dts[i]);
+					}
+				}
+
+				void swap(u32 a, u32 b) override {
+					assert(a < _scripts.size() && b < _scripts.size());
+					if (a == b) return;
+					alignas(script_class) u8 temp[sizeof(script_class)];
+					memcpy(temp, (void*)&_scripts[a], sizeof(script_class));
+					memcpy((void*)&_scripts[a], (void*)&_scripts[b], sizeof(script_class));
+					memcpy((void*)&_scripts[b], temp, sizeof(script_class));
+				}
+
+				[[nodiscard]] entity_script& get(u32 index) override { return _scripts[index]; }
+				[[nodiscard]] u32 size() const override { return (u32)_scripts.size(); }
+				[[nodiscard]] update_access access() const override { return script_class::access; }
+				[[nodiscard]] u32 tick_interval() const override { return script_class::tick_interval; }
+				[[nodiscard]] update_priority priority() const override { return script_class::priority; }
+
+			private:
+				utl::vector<script_class> _scripts;
+			};
+
+			using script_creator = script_pool_base& (*)();
 			using string_hash = std::hash<std::string>;
 
 			u8 register_script(size_t, script_creator);
 #ifdef USE_WITH_EDITOR
 			extern "C" __declspec(dllexport)
 #endif  // USE_WITH_EDITOR
+			// Returns nullptr if no script type with this tag is registered
 			script_creator get_script_creator(size_t tag);
 
+			// Returns the pool that stores all scripts of type 'script_class'
 			template <class script_class>
-			script_ptr create_script(game_entity::entity entity) {
-				assert(entity.is_valid());
-				return std::make_unique<script_class>(entity);
+			script_pool_base& get_script_pool() {
+				static_assert(std::is_base_of_v<entity_script, script_class>);
+				static script_pool<script_class> pool;
+				return pool;
 			}
 
 #ifdef USE_WITH_EDITOR
@@ -59,7 +165,7 @@ namespace primal {
 				const u8 _reg_##TYPE{															\
 					primal::script::detail::register_script(									\
 					primal::script::detail::string_hash()(#TYPE),								\
-					&primal::script::detail::create_script<TYPE>) };							\
+					&primal::script::detail::get_script_pool<TYPE>) };						\
 				const u8 _name_##TYPE{ primal::script::detail::add_script_name(#TYPE) };		\
 			}
 #else
@@ -67,7 +173,7 @@ namespace primal {
 			namespace {																			\
 				const u8 _reg_##TYPE{ primal::script::detail::register_script(					\
 					primal::script::detail::string_hash()(#TYPE),								\
-					&primal::script::detail::create_script<TYPE>) };							\
+					&primal::script::detail::get_script_pool<TYPE>) };						\
 			}
 #endif  // USE_WITH_EDITOR
 		}  // namespace detail
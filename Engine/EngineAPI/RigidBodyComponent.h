@@ -0,0 +1,27 @@
+#pragma once
+#include"..\Components\ComponentsCommon.h"
+
+namespace primal::rigid_body {
+
+	DEFINE_TYPED_ID(rigid_body_id);
+
+	class component final {
+
+	public:
+		constexpr explicit component(rigid_body_id id) : _id{ id } {}
+		constexpr component() : _id{ id::invalid_id } {}
+		constexpr rigid_body_id get_id() const { return _id; }
+		constexpr bool is_valid() const { return id::is_valid(_id); }
+
+		math::v3 velocity() const;
+		math::v3 angular_velocity() const;
+
+		void set_velocity(math::v3 velocity);
+		void set_angular_velocity(math::v3 angular_velocity);
+		// Changes the velocity of a body with mass at once. Static bodies ignore impulses.
+		void apply_impulse(math::v3 impulse);
+
+	private:
+		rigid_body_id _id;
+	};
+}
\ No newline at end of file
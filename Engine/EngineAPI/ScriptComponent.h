@@ -13,6 +13,11 @@ namespace primal::script {
 		constexpr script_id get_id() const { return _id; }
 		constexpr bool is_valid() const { return id::is_valid(_id); }
 
+		// Stops updating the script until 'time' has passed (in the units of dt), or until wake() is called.
+		// A negative time sleeps until wake() is called. Both take effect at the start of the next script update.
+		void sleep(float time = -1.f);
+		void wake();
+
 	private:
 		script_id _id;
 	};
@@ -0,0 +1,19 @@
+#pragma once
+#include"..\Components\ComponentsCommon.h"
+
+namespace primal::content {
+
+	// World partition. The editor groups entities into square cells on the xz plane. Cells closer than
+	// load_radius to a focus point are loaded in time slices by the frame scheduler, and loaded cells are
+	// unloaded once they're farther than unload_radius from every focus point.
+	struct streaming_settings {
+		f32 load_radius{ 128.f };
+		f32 unload_radius{ 192.f };	// larger than load_radius, so cells at the border don't load and unload repeatedly
+	};
+
+	void set_streaming_settings(const streaming_settings& settings);
+	// Sets the points around which cells are loaded, e.g. the camera or the players. Call it whenever they move.
+	// NOTE: until focus points are set, or after they're cleared with count 0, every cell is loaded.
+	void set_focus_points(const math::v3* const points, u32 count);
+	[[nodiscard]] u32 loaded_cell_count();
+}
\ No newline at end of file
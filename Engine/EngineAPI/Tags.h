@@ -0,0 +1,34 @@
+#pragma once
+#include"..\Components\ComponentsCommon.h"
+
+namespace primal::tags {
+
+	// Tags and names are interned, so each distinct string is stored once and entities refer to it by id.
+	// There are at most 64 tags, so the tags of an entity fit in one bitmask.
+	using tag_mask = u64;
+	constexpr u32 max_tags{ 64 };
+
+	// Returns the id of the tag called name. The tag is registered the first time it is used.
+	// Returns u32_invalid_id when all tags are in use.
+	[[nodiscard]] u32 get_tag(const char* name);
+	[[nodiscard]] constexpr tag_mask to_mask(u32 tag) { return tag < max_tags ? tag_mask{ 1 } << tag : 0; }
+
+	void add_tag(game_entity::entity_id id, u32 tag);
+	void remove_tag(game_entity::entity_id id, u32 tag);
+	[[nodiscard]] tag_mask get_tags(game_entity::entity_id id);
+	// Returns true if the entity has all tags in mask
+	[[nodiscard]] bool has_tags(game_entity::entity_id id, tag_mask mask);
+
+	// Entities that have a tag, in no particular order. The list changes when the tag is added or removed.
+	[[nodiscard]] const utl::vector<game_entity::entity_id>& with_tag(u32 tag);
+	// Appends the entities that have all tags in mask. Only the entities of the rarest of these tags are checked.
+	void with_tags(tag_mask mask, utl::vector<game_entity::entity_id>& results);
+
+	// Several entities may have the same name. Setting an empty name or nullptr removes the name.
+	void set_name(game_entity::entity_id id, const char* name);
+	// Returns an empty string if the entity has no name
+	[[nodiscard]] const char* get_name(game_entity::entity_id id);
+	// Returns one of the entities called name, or an invalid id if there is none
+	[[nodiscard]] game_entity::entity_id find(const char* name);
+	[[nodiscard]] const utl::vector<game_entity::entity_id>& find_all(const char* name);
+}
\ No newline at end of file
@@ -17,6 +17,10 @@ namespace primal::transform {
 		math::v3 position() const;
 		math::v3 scale() const;
 
+		void set_rotation(math::v4 rotation);
+		void set_position(math::v3 position);
+		void set_scale(math::v3 scale);
+
 	private:
 		transform_id _id;
 	};
@@ -0,0 +1,231 @@
+#include "AabbTree.h"
+
+namespace primal::spatial {
+
+	u32 aabb_tree::insert(const aabb& bounds, u32 user_data) {
+		const u32 leaf{ allocate_node() };
+		node& n{ _nodes[leaf] };
+		n.tight = bounds;
+		n.fat = expand(bounds, _margin);
+		n.user_data = user_data;
+		n.height = 0;
+
+		insert_leaf(leaf);
+		++_leaf_count;
+		return leaf;
+	}
+
+	void aabb_tree::remove(u32 leaf) {
+		assert(is_leaf(leaf) && _leaf_count);
+		remove_leaf(leaf);
+		free_node(leaf);
+		--_leaf_count;
+	}
+
+	bool aabb_tree::move(u32 leaf, const aabb& bounds) {
+		assert(is_leaf(leaf));
+		node& n{ _nodes[leaf] };
+		n.tight = bounds;
+		if (contains(n.fat, bounds)) return false;
+
+		remove_leaf(leaf);
+		_nodes[leaf].fat = expand(bounds, _margin);
+		insert_leaf(leaf);
+		return true;
+	}
+
+	void aabb_tree::clear() {
+		_nodes.clear();
+		_root = u32_invalid_id;
+		_free_list = u32_invalid_id;
+		_leaf_count = 0;
+	}
+
+	bool aabb_tree::raycast(const ray& r, u32& user_data, f32& distance) const {
+		if (_root == u32_invalid_id) return false;
+
+		bool hit{ false };
+		f32 closest{ r.max_distance };
+		u32 stack[max_stack_size];
+		u32 stack_size{ 0 };
+		stack[stack_size++] = _root;
+		while (stack_size) {
+			const node& n{ _nodes[stack[--stack_size]] };
+			f32 t;
+			// NOTE: nodes that are farther away than the closest hit so far are skipped
+			if (n.left == u32_invalid_id) {
+				if (intersects(r, n.tight, closest, t) && (!hit || t < closest)) {
+					hit = true;
+					closest = t;
+					user_data = n.user_data;
+				}
+			}
+			else if (intersects(r, n.fat, closest, t)) {
+				assert(stack_size + 2 <= max_stack_size);
+				stack[stack_size++] = n.left;
+				stack[stack_size++] = n.right;
+			}
+		}
+
+		if (hit) distance = closest;
+		return hit;
+	}
+
+	u32 aabb_tree::allocate_node() {
+		if (_free_list == u32_invalid_id) {
+			_nodes.emplace_back();
+			return (u32)_nodes.size() - 1;
+		}
+
+		const u32 index{ _free_list };
+		_free_list = _nodes[index].parent;
+		_nodes[index] = {};
+		return index;
+	}
+
+	void aabb_tree::free_node(u32 index) {
+		assert(index < _nodes.size());
+		_nodes[index] = {};
+		_nodes[index].parent = _free_list;
+		_free_list = index;
+	}
+
+	void aabb_tree::insert_leaf(u32 leaf) {
+		if (_root == u32_invalid_id) {
+			_root = leaf;
+			_nodes[leaf].parent = u32_invalid_id;
+			return;
+		}
+
+		// find the best sibling for the new leaf
+		const aabb leaf_box{ _nodes[leaf].fat };
+		u32 index{ _root };
+		while (!is_leaf(index)) {
+			const node& n{ _nodes[index] };
+			const f32 combined_area{ half_area(merge(n.fat, leaf_box)) };
+			// cost of making a new parent for this node and the new leaf
+			const f32 cost{ 2.f * combined_area };
+			// minimum cost that going further down adds to the ancestors
+			const f32 inheritance_cost{ 2.f * (combined_area - half_area(n.fat)) };
+
+			auto descend_cost = [&](u32 child) {
+				const aabb& box{ _nodes[child].fat };
+				const f32 area{ half_area(merge(box, leaf_box)) };
+				return (is_leaf(child) ? area : area - half_area(box)) + inheritance_cost;
+			};
+
+			const f32 left_cost{ descend_cost(n.left) };
+			const f32 right_cost{ descend_cost(n.right) };
+			if (cost < left_cost && cost < right_cost) break;
+
+			index = left_cost < right_cost ? n.left : n.right;
+		}
+
+		// make a new parent for the sibling and the leaf
+		const u32 sibling{ index };
+		const u32 old_parent{ _nodes[sibling].parent };
+		const u32 new_parent{ allocate_node() };
+		node& p{ _nodes[new_parent] };
+		p.parent = old_parent;
+		p.fat = merge(leaf_box, _nodes[sibling].fat);
+		p.height = _nodes[sibling].height + 1;
+		p.left = sibling;
+		p.right = leaf;
+		_nodes[sibling].parent = new_parent;
+		_nodes[leaf].parent = new_parent;
+
+		if (old_parent == u32_invalid_id) {
+			_root = new_parent;
+		}
+		else if (_nodes[old_parent].left == sibling) {
+			_nodes[old_parent].left = new_parent;
+		}
+		else {
+			_nodes[old_parent].right = new_parent;
+		}
+
+		refit_ancestors(new_parent);
+	}
+
+	void aabb_tree::remove_leaf(u32 leaf) {
+		if (leaf == _root) {
+			_root = u32_invalid_id;
+			return;
+		}
+
+		const u32 parent{ _nodes[leaf].parent };
+		const u32 grand_parent{ _nodes[parent].parent };
+		const u32 sibling{ _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left };
+
+		// the sibling takes the place of the parent
+		_nodes[sibling].parent = grand_parent;
+		free_node(parent);
+		if (grand_parent == u32_invalid_id) {
+			_root = sibling;
+			return;
+		}
+
+		if (_nodes[grand_parent].left == parent) _nodes[grand_parent].left = sibling;
+		else _nodes[grand_parent].right = sibling;
+		refit_ancestors(grand_parent);
+	}
+
+	// Rotates a grand child up if one child of 'index' is more than one level higher than the other.
+	// Returns the node that took the place of 'index'.
+	u32 aabb_tree::balance(u32 index) {
+		node& a{ _nodes[index] };
+		if (a.left == u32_invalid_id || a.height < 2) return index;
+
+		const u32 ib{ a.left };
+		const u32 ic{ a.right };
+		node& b{ _nodes[ib] };
+		node& c{ _nodes[ic] };
+		const s32 difference{ (s32)c.height - (s32)b.height };
+
+		if (difference > 1 || difference < -1) {
+			// rotate the higher child (up) above 'a'. 'a' keeps the lower child and the lower grand child.
+			const bool c_up{ difference > 1 };
+			const u32 i_up{ c_up ? ic : ib };
+			node& up{ _nodes[i_up] };
+			node& low{ c_up ? b : c };
+			const u32 i1{ up.left };
+			const u32 i2{ up.right };
+			const bool first_higher{ _nodes[i1].height > _nodes[i2].height };
+			const u32 i_keep{ first_higher ? i1 : i2 };
+			const u32 i_move{ first_higher ? i2 : i1 };
+
+			up.left = index;
+			up.right = i_keep;
+			up.parent = a.parent;
+			a.parent = i_up;
+
+			if (up.parent == u32_invalid_id) _root = i_up;
+			else if (_nodes[up.parent].left == index) _nodes[up.parent].left = i_up;
+			else _nodes[up.parent].right = i_up;
+
+			if (c_up) a.right = i_move;
+			else a.left = i_move;
+			_nodes[i_move].parent = index;
+
+			a.fat = merge(low.fat, _nodes[i_move].fat);
+			a.height = 1 + std::max(low.height, _nodes[i_move].height);
+			up.fat = merge(a.fat, _nodes[i_keep].fat);
+			up.height = 1 + std::max(a.height, _nodes[i_keep].height);
+			return i_up;
+		}
+
+		return index;
+	}
+
+	void aabb_tree::refit_ancestors(u32 index) {
+		while (index != u32_invalid_id) {
+			index = balance(index);
+			node& n{ _nodes[index] };
+			const node& left{ _nodes[n.left] };
+			const node& right{ _nodes[n.right] };
+			n.height = 1 + std::max(left.height, right.height);
+			n.fat = merge(left.fat, right.fat);
+			index = n.parent;
+		}
+	}
+}
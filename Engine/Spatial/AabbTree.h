@@ -0,0 +1,93 @@
+#pragma once
+#include "SpatialCommon.h"
+
+namespace primal::spatial {
+
+	// Dynamic bounding volume tree. Each leaf stores the tight bounds of an object and a fat copy that is
+	// enlarged by a margin, so that objects which move a little don't have to be reinserted.
+	// New leaves are placed next to the sibling that increases the surface area of the tree the least (SAH),
+	// and the tree is kept balanced with rotations.
+	// NOTE: queries are const and can run on several threads at the same time, as long as the tree isn't changed.
+	class aabb_tree {
+	public:
+		explicit aabb_tree(f32 margin = 0.1f) : _margin{ margin } {}
+
+		// Adds a leaf and returns its handle
+		u32 insert(const aabb& bounds, u32 user_data);
+		void remove(u32 leaf);
+		// Sets the tight bounds of a leaf. Returns true if the leaf was reinserted because
+		// the new bounds are no longer inside its fat bounds.
+		bool move(u32 leaf, const aabb& bounds);
+		void clear();
+
+		[[nodiscard]] u32 user_data(u32 leaf) const { assert(is_leaf(leaf)); return _nodes[leaf].user_data; }
+		[[nodiscard]] const aabb& bounds(u32 leaf) const { assert(is_leaf(leaf)); return _nodes[leaf].tight; }
+		[[nodiscard]] const aabb& fat_bounds(u32 leaf) const { assert(is_leaf(leaf)); return _nodes[leaf].fat; }
+		[[nodiscard]] u32 height() const { return _root == u32_invalid_id ? 0 : _nodes[_root].height; }
+		[[nodiscard]] u32 leaf_count() const { return _leaf_count; }
+
+		// Calls func(user_data) for each leaf whose tight bounds overlap 'box'
+		template<typename F> void query(const aabb& box, F&& func) const {
+			traverse([&box](const aabb& b) { return overlaps(b, box); }, func);
+		}
+
+		// Calls func(user_data) for each leaf whose tight bounds overlap 's'
+		template<typename F> void query(const sphere& s, F&& func) const {
+			traverse([&s](const aabb& b) { return overlaps(b, s); }, func);
+		}
+
+		// Finds the closest leaf that the ray hits. Returns false if there's none.
+		bool raycast(const ray& r, u32& user_data, f32& distance) const;
+
+	private:
+		struct node {
+			aabb fat;
+			aabb tight;					// only used by leaves
+			u32 parent{ u32_invalid_id };	// next free node for nodes in the free list
+			u32 left{ u32_invalid_id };
+			u32 right{ u32_invalid_id };
+			u32 user_data{ u32_invalid_id };
+			u32 height{ 0 };			// leaves have height 0
+		};
+
+		// NOTE: the stack holds at most one node per level of the tree plus one,
+		//		 and balancing keeps the height way below this.
+		static constexpr u32 max_stack_size{ 256 };
+
+		[[nodiscard]] bool is_leaf(u32 index) const {
+			assert(index < _nodes.size());
+			return _nodes[index].left == u32_invalid_id;
+		}
+
+		template<typename T, typename F> void traverse(T&& test, F&& func) const {
+			if (_root == u32_invalid_id) return;
+			u32 stack[max_stack_size];
+			u32 stack_size{ 0 };
+			stack[stack_size++] = _root;
+			while (stack_size) {
+				const node& n{ _nodes[stack[--stack_size]] };
+				if (n.left == u32_invalid_id) {
+					if (test(n.tight)) func(n.user_data);
+				}
+				else if (test(n.fat)) {
+					assert(stack_size + 2 <= max_stack_size);
+					stack[stack_size++] = n.left;
+					stack[stack_size++] = n.right;
+				}
+			}
+		}
+
+		u32 allocate_node();
+		void free_node(u32 index);
+		void insert_leaf(u32 leaf);
+		void remove_leaf(u32 leaf);
+		u32 balance(u32 index);
+		void refit_ancestors(u32 index);
+
+		utl::vector<node> _nodes;
+		u32 _root{ u32_invalid_id };
+		u32 _free_list{ u32_invalid_id };
+		u32 _leaf_count{ 0 };
+		f32 _margin;
+	};
+}
@@ -0,0 +1,269 @@
+#include "HashGrid.h"
+#include "..\Components\Transform.h"
+#include "..\Core\JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace primal::spatial {
+
+	// anonymous namespace
+	namespace {
+		constexpr u32 build_range_size{ 4096 };
+		constexpr u32 query_range_size{ 64 };
+		constexpr u32 min_bucket_count{ 64 };
+
+		f32 distance_sq(math::v3 a, math::v3 b) {
+			const f32 dx{ a.x - b.x }, dy{ a.y - b.y }, dz{ a.z - b.z };
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+		struct neighbor {
+			f32 distance_sq;
+			u32 user_data;
+		};
+
+		bool closer(const neighbor& a, const neighbor& b) {
+			return a.distance_sq < b.distance_sq;
+		}
+
+		// NOTE: different cells can hash to the same bucket. Queries stamp the buckets they visit with
+		//		 their own epoch and skip the buckets that already have it, so that no point is reported twice.
+		//		 Each thread has its own stamps, because queries can run on several threads at the same time.
+		thread_local utl::vector<u32> visited_epochs;
+		thread_local u32 query_epoch{ 0 };
+		thread_local utl::vector<neighbor> nearest;
+
+		void begin_visits(u32 bucket_count) {
+			if (visited_epochs.size() < bucket_count) visited_epochs.resize(bucket_count);
+			if (++query_epoch == 0) {
+				// all stamps may be stale after the epoch wraps around
+				memset(visited_epochs.data(), 0, visited_epochs.size() * sizeof(u32));
+				query_epoch = 1;
+			}
+		}
+
+		bool visit(u32 bucket) {
+			if (visited_epochs[bucket] == query_epoch) return false;
+			visited_epochs[bucket] = query_epoch;
+			return true;
+		}
+	} // anonymous namespace
+
+	void hash_grid::set_cell_size(f32 cell_size) {
+		assert(cell_size > 0.f);
+		_cell_size = cell_size;
+		_inv_cell_size = 1.f / cell_size;
+	}
+
+	s32 hash_grid::cell_of(f32 x) const {
+		return (s32)std::floor(x * _inv_cell_size);
+	}
+
+	u32 hash_grid::bucket_of(s32 x, s32 y, s32 z) const {
+		return (((u32)x * 73856093u) ^ ((u32)y * 19349663u) ^ ((u32)z * 83492791u)) & _bucket_mask;
+	}
+
+	void hash_grid::build(const math::v3* const positions, const u32* const user_data, u32 count) {
+		assert((positions && user_data) || !count);
+		build_buckets(positions, [user_data](u32 i) { return user_data[i]; }, count);
+	}
+
+	template<typename F>
+	void hash_grid::build_buckets(const math::v3* const positions, F user_data_of, u32 count) {
+		// about two buckets per point keeps the collisions low
+		u32 bucket_count{ min_bucket_count };
+		while (bucket_count < 2 * count) bucket_count <<= 1;
+		_bucket_mask = bucket_count - 1;
+
+		_entry_buckets.resize(count);
+		_bucket_start.resize(bucket_count + 1);
+		memset(_bucket_start.data(), 0, _bucket_start.size() * sizeof(u32));
+
+		// 1) find the bucket of each point, count the points per bucket and find the range of cells
+		u32* const buckets{ _entry_buckets.data() };
+		u32* const counts{ _bucket_start.data() };
+		for (u32 axis{ 0 }; axis < 3; ++axis) {
+			_min_cell[axis] = INT32_MAX;
+			_max_cell[axis] = INT32_MIN;
+		}
+
+		std::mutex extent_mutex;
+		jobs::parallel_for(count, build_range_size, [&](u32 first, u32 last) {
+			s32 min_cell[3]{ INT32_MAX, INT32_MAX, INT32_MAX };
+			s32 max_cell[3]{ INT32_MIN, INT32_MIN, INT32_MIN };
+			for (u32 i{ first }; i < last; ++i) {
+				if (user_data_of(i) == u32_invalid_id) {
+					buckets[i] = u32_invalid_id;
+					continue;
+				}
+
+				const math::v3& p{ positions[i] };
+				const s32 cell[3]{ cell_of(p.x), cell_of(p.y), cell_of(p.z) };
+				buckets[i] = bucket_of(cell[0], cell[1], cell[2]);
+				std::atomic_ref<u32>{ counts[buckets[i]] }.fetch_add(1, std::memory_order_relaxed);
+				for (u32 axis{ 0 }; axis < 3; ++axis) {
+					min_cell[axis] = std::min(min_cell[axis], cell[axis]);
+					max_cell[axis] = std::max(max_cell[axis], cell[axis]);
+				}
+			}
+
+			std::lock_guard lock{ extent_mutex };
+			for (u32 axis{ 0 }; axis < 3; ++axis) {
+				_min_cell[axis] = std::min(_min_cell[axis], min_cell[axis]);
+				_max_cell[axis] = std::max(_max_cell[axis], max_cell[axis]);
+			}
+			});
+
+		// 2) the start of each bucket is the sum of the counts before it
+		u32 sum{ 0 };
+		for (u32 i{ 0 }; i <= bucket_count; ++i) {
+			const u32 c{ counts[i] };
+			counts[i] = sum;
+			sum += c;
+		}
+
+		// 3) scatter the points into their buckets
+		_cursors.resize(bucket_count);
+		memcpy(_cursors.data(), counts, bucket_count * sizeof(u32));
+		_entries.resize(sum);
+		u32* const cursors{ _cursors.data() };
+		entry* const entries{ _entries.data() };
+		jobs::parallel_for(count, build_range_size, [&](u32 first, u32 last) {
+			for (u32 i{ first }; i < last; ++i) {
+				if (buckets[i] == u32_invalid_id) continue;
+				const u32 index{ std::atomic_ref<u32>{ cursors[buckets[i]] }.fetch_add(1, std::memory_order_relaxed) };
+				entries[index] = { positions[i], user_data_of(i) };
+			}
+			});
+	}
+
+	void hash_grid::build_from_transforms() {
+		// NOTE: transform ids are entity ids and slots of removed transforms have invalid ids, which are skipped
+		const transform::transform_id* const owners{ transform::slot_owners() };
+		build_buckets(transform::slot_positions(), [owners](u32 i) { return (u32)(id::id_type)owners[i]; }, transform::count());
+	}
+
+	void hash_grid::query(const sphere& s, utl::vector<u32>& results) const {
+		if (_entries.empty()) return;
+
+		const f32 radius_sq{ s.radius * s.radius };
+		const s32 x0{ std::max(cell_of(s.center.x - s.radius), _min_cell[0]) }, x1{ std::min(cell_of(s.center.x + s.radius), _max_cell[0]) };
+		const s32 y0{ std::max(cell_of(s.center.y - s.radius), _min_cell[1]) }, y1{ std::min(cell_of(s.center.y + s.radius), _max_cell[1]) };
+		const s32 z0{ std::max(cell_of(s.center.z - s.radius), _min_cell[2]) }, z1{ std::min(cell_of(s.center.z + s.radius), _max_cell[2]) };
+		if (x0 > x1 || y0 > y1 || z0 > z1) return;
+
+		// NOTE: when the sphere covers more cells than there are buckets, testing every point is cheaper
+		const u32 bucket_count{ _bucket_mask + 1 };
+		if ((u64)(x1 - x0 + 1) * (u64)(y1 - y0 + 1) * (u64)(z1 - z0 + 1) >= bucket_count) {
+			for (const entry& e : _entries) {
+				if (distance_sq(e.position, s.center) <= radius_sq) results.emplace_back(e.user_data);
+			}
+			return;
+		}
+
+		begin_visits(bucket_count);
+		for (s32 z{ z0 }; z <= z1; ++z) {
+			for (s32 y{ y0 }; y <= y1; ++y) {
+				for (s32 x{ x0 }; x <= x1; ++x) {
+					const u32 bucket{ bucket_of(x, y, z) };
+					if (!visit(bucket)) continue;
+
+					for (u32 i{ _bucket_start[bucket] }; i < _bucket_start[bucket + 1]; ++i) {
+						if (distance_sq(_entries[i].position, s.center) <= radius_sq) {
+							results.emplace_back(_entries[i].user_data);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void hash_grid::query_nearest(math::v3 point, u32 k, f32 max_distance, utl::vector<u32>& results) const {
+		if (_entries.empty() || !k) return;
+
+		const f32 max_distance_sq{ max_distance * max_distance };
+		const s32 c[3]{ cell_of(point.x), cell_of(point.y), cell_of(point.z) };
+		// NOTE: the number of visited cells grows with the cube of the distance, so keep max_distance small.
+		//		 Rings that are larger than needed to cover all cells with points can't find anything new.
+		s32 max_ring{ (s32)std::min(std::ceil(max_distance * _inv_cell_size), 1024.f) };
+		s32 populated_ring{ 0 };
+		for (u32 axis{ 0 }; axis < 3; ++axis) {
+			populated_ring = std::max({ populated_ring, c[axis] - _min_cell[axis], _max_cell[axis] - c[axis] });
+		}
+		max_ring = std::min(max_ring, populated_ring);
+
+		const auto visit_cell = [&](s32 x, s32 y, s32 z) {
+			if (x < _min_cell[0] || x > _max_cell[0]) return;
+			const u32 bucket{ bucket_of(x, y, z) };
+			if (!visit(bucket)) return;
+
+			for (u32 i{ _bucket_start[bucket] }; i < _bucket_start[bucket + 1]; ++i) {
+				const neighbor n{ distance_sq(_entries[i].position, point), _entries[i].user_data };
+				if (n.distance_sq > max_distance_sq) continue;
+				if (nearest.size() < k) {
+					nearest.emplace_back(n);
+					std::push_heap(nearest.begin(), nearest.end(), closer);
+				}
+				else if (n.distance_sq < nearest.front().distance_sq) {
+					std::pop_heap(nearest.begin(), nearest.end(), closer);
+					nearest.back() = n;
+					std::push_heap(nearest.begin(), nearest.end(), closer);
+				}
+			}
+		};
+
+		// NOTE: 'nearest' is a max-heap of the k closest points found so far
+		nearest.clear();
+		begin_visits(_bucket_mask + 1);
+		for (s32 ring{ 0 }; ring <= max_ring; ++ring) {
+			// visit the cells on the surface of the cube of cells around the point's cell, within the populated range
+			const s32 z0{ std::max(c[2] - ring, _min_cell[2]) }, z1{ std::min(c[2] + ring, _max_cell[2]) };
+			const s32 y0{ std::max(c[1] - ring, _min_cell[1]) }, y1{ std::min(c[1] + ring, _max_cell[1]) };
+			for (s32 z{ z0 }; z <= z1; ++z) {
+				for (s32 y{ y0 }; y <= y1; ++y) {
+					if (std::abs(z - c[2]) < ring && std::abs(y - c[1]) < ring) {
+						visit_cell(c[0] - ring, y, z);
+						if (ring) visit_cell(c[0] + ring, y, z);
+						continue;
+					}
+
+					const s32 x1{ std::min(c[0] + ring, _max_cell[0]) };
+					for (s32 x{ std::max(c[0] - ring, _min_cell[0]) }; x <= x1; ++x) {
+						visit_cell(x, y, z);
+					}
+				}
+			}
+
+			// NOTE: points in cells outside of this ring are at least ring * cell_size away
+			const f32 covered{ (f32)ring * _cell_size };
+			if (nearest.size() == k && nearest.front().distance_sq <= covered * covered) break;
+		}
+
+		std::sort_heap(nearest.begin(), nearest.end(), closer);
+		for (const neighbor& n : nearest) {
+			results.emplace_back(n.user_data);
+		}
+	}
+
+	void hash_grid::query(const sphere* const spheres, u32 count, utl::vector<u32>* const results) const {
+		assert(spheres && results);
+		jobs::parallel_for(count, query_range_size, [this, spheres, results](u32 first, u32 last) {
+			for (u32 i{ first }; i < last; ++i) {
+				results[i].clear();
+				query(spheres[i], results[i]);
+			}
+			});
+	}
+
+	void hash_grid::query_nearest(const math::v3* const points, u32 count, u32 k, f32 max_distance, utl::vector<u32>* const results) const {
+		assert(points && results);
+		jobs::parallel_for(count, query_range_size, [this, points, k, max_distance, results](u32 first, u32 last) {
+			for (u32 i{ first }; i < last; ++i) {
+				results[i].clear();
+				query_nearest(points[i], k, max_distance, results[i]);
+			}
+			});
+	}
+}
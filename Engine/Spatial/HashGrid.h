@@ -0,0 +1,56 @@
+#pragma once
+#include "SpatialCommon.h"
+
+namespace primal::spatial {
+
+	// Uniform grid for many small objects of about the same size, e.g. crowd agents. Cells are hashed into
+	// a table, so the grid has no bounds. The grid is rebuilt from scratch with a parallel counting sort,
+	// which stores the points of each bucket next to each other.
+	// NOTE: queries are const and can run on several threads at the same time, but not during build().
+	class hash_grid {
+	public:
+		explicit hash_grid(f32 cell_size = 1.f) { set_cell_size(cell_size); }
+
+		// Cell size should be about the radius of the most common queries
+		void set_cell_size(f32 cell_size);
+		[[nodiscard]] f32 cell_size() const { return _cell_size; }
+
+		// Rebuilds the grid. Points with user data u32_invalid_id are skipped.
+		void build(const math::v3* const positions, const u32* const user_data, u32 count);
+		// Rebuilds the grid from the positions of all transforms, with their entity ids as user data
+		void build_from_transforms();
+
+		[[nodiscard]] u32 size() const { return (u32)_entries.size(); }
+
+		// Appends the user data of all points within the sphere
+		void query(const sphere& s, utl::vector<u32>& results) const;
+		// Appends the user data of the (at most) k points that are closest to 'point' and not farther than
+		// 'max_distance', closest first. NOTE: a point in the grid finds itself first.
+		void query_nearest(math::v3 point, u32 k, f32 max_distance, utl::vector<u32>& results) const;
+
+		// Batched queries, which are spread over the job system. results[i] is cleared and filled by query i.
+		void query(const sphere* const spheres, u32 count, utl::vector<u32>* const results) const;
+		void query_nearest(const math::v3* const points, u32 count, u32 k, f32 max_distance, utl::vector<u32>* const results) const;
+
+	private:
+		struct entry {
+			math::v3 position;
+			u32 user_data;
+		};
+
+		[[nodiscard]] s32 cell_of(f32 x) const;
+		[[nodiscard]] u32 bucket_of(s32 x, s32 y, s32 z) const;
+		// 'user_data_of(i)' returns the user data of point i
+		template<typename F> void build_buckets(const math::v3* const positions, F user_data_of, u32 count);
+
+		utl::vector<entry> _entries;		// sorted by bucket
+		utl::vector<u32> _bucket_start;		// first entry of each bucket, plus the end of the last one
+		utl::vector<u32> _entry_buckets;	// scratch for build()
+		utl::vector<u32> _cursors;			// scratch for build()
+		s32 _min_cell[3]{};				// range of cells that contain points. Queries don't look outside of it.
+		s32 _max_cell[3]{ -1, -1, -1 };
+		f32 _cell_size{ 1.f };
+		f32 _inv_cell_size{ 1.f };
+		u32 _bucket_mask{ 0 };
+	};
+}
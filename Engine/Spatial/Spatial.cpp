@@ -0,0 +1,223 @@
+#include "Spatial.h"
+#include "AabbTree.h"
+#include "SweepAndPrune.h"
+#include "..\Components\Entity.h"
+#include "..\Components\Transform.h"
+#include "..\Core\JobSystem.h"
+
+#include <cmath>
+
+namespace primal::spatial {
+
+	// anonymous namespace
+	namespace {
+		aabb_tree entity_tree;
+		// leaf and local bounds of each entity, indexed by id::index() of the entity id
+		utl::vector<u32> leaves;
+		utl::vector<bounds_info> local_bounds;
+
+		// NOTE: only entities with overlap events have a broadphase proxy
+		sweep_and_prune broadphase;
+		utl::vector<u32> proxies;
+		utl::vector<entity_pair> added_entity_pairs;
+		utl::vector<entity_pair> removed_entity_pairs;
+
+		hash_grid agent_grid;
+		bool grid_enabled{ false };
+
+		constexpr u32 query_range_size{ 16 };
+
+		aabb world_bounds(game_entity::entity entity, const bounds_info& info) {
+			const transform::component t{ entity.transform() };
+			const math::v4 q{ t.rotation() };
+			const math::v3 p{ t.position() };
+			const math::v3 s{ t.scale() };
+
+			// rotation matrix from quaternion
+			const f32 xx{ q.x * q.x }, yy{ q.y * q.y }, zz{ q.z * q.z };
+			const f32 xy{ q.x * q.y }, xz{ q.x * q.z }, yz{ q.y * q.z };
+			const f32 xw{ q.x * q.w }, yw{ q.y * q.w }, zw{ q.z * q.w };
+			const f32 r[3][3]{
+				{ 1.f - 2.f * (yy + zz), 2.f * (xy - zw), 2.f * (xz + yw) },
+				{ 2.f * (xy + zw), 1.f - 2.f * (xx + zz), 2.f * (yz - xw) },
+				{ 2.f * (xz - yw), 2.f * (yz + xw), 1.f - 2.f * (xx + yy) },
+			};
+
+			const f32 c[3]{ info.center.x * s.x, info.center.y * s.y, info.center.z * s.z };
+			const f32 h[3]{ info.half_extents.x * std::abs(s.x), info.half_extents.y * std::abs(s.y), info.half_extents.z * std::abs(s.z) };
+			f32 center[3]{ p.x, p.y, p.z };
+			f32 extents[3]{};
+			for (u32 i{ 0 }; i < 3; ++i) {
+				for (u32 j{ 0 }; j < 3; ++j) {
+					center[i] += r[i][j] * c[j];
+					// NOTE: the extents of a rotated box are the sums of the absolute rotated half extents
+					extents[i] += std::abs(r[i][j]) * h[j];
+				}
+			}
+
+			return {
+				{ center[0] - extents[0], center[1] - extents[1], center[2] - extents[2] },
+				{ center[0] + extents[0], center[1] + extents[1], center[2] + extents[2] }
+			};
+		}
+
+		bool is_in_index(game_entity::entity_id id) {
+			const id::id_type index{ id::index(id) };
+			return index < leaves.size() && leaves[index] != u32_invalid_id &&
+				entity_tree.user_data(leaves[index]) == (u32)id;
+		}
+	} // anonymous namespace
+
+	void add(game_entity::entity entity, bounds_info info) {
+		assert(entity.is_valid() && game_entity::is_alive(entity.get_id()));
+		assert(!contains(entity.get_id()));
+		const id::id_type index{ id::index(entity.get_id()) };
+		while (leaves.size() <= index) {
+			leaves.emplace_back(u32_invalid_id);
+			local_bounds.emplace_back();
+			proxies.emplace_back(u32_invalid_id);
+		}
+
+		const aabb bounds{ world_bounds(entity, info) };
+		local_bounds[index] = info;
+		leaves[index] = entity_tree.insert(bounds, (u32)entity.get_id());
+		proxies[index] = info.overlap_events ? broadphase.add(bounds, (u32)entity.get_id()) : u32_invalid_id;
+	}
+
+	void remove(game_entity::entity_id id) {
+		if (!is_in_index(id)) return;
+		const id::id_type index{ id::index(id) };
+		entity_tree.remove(leaves[index]);
+		leaves[index] = u32_invalid_id;
+		if (proxies[index] != u32_invalid_id) {
+			broadphase.remove(proxies[index]);
+			proxies[index] = u32_invalid_id;
+		}
+	}
+
+	bool contains(game_entity::entity_id id) {
+		return is_in_index(id);
+	}
+
+	u64 snapshot_size() {
+		return sizeof(u32) + entity_tree.leaf_count() * (sizeof(game_entity::entity_id) + sizeof(bounds_info));
+	}
+
+	void save_snapshot(utl::blob_stream_writer& writer) {
+		writer.write(entity_tree.leaf_count());
+		for (u32 i{ 0 }; i < leaves.size(); ++i) {
+			if (leaves[i] == u32_invalid_id) continue;
+			writer.write(entity_tree.user_data(leaves[i]));
+			writer.write((const u8*)&local_bounds[i], sizeof(bounds_info));
+		}
+	}
+
+	void restore_snapshot(utl::blob_stream_reader& reader) {
+		entity_tree.clear();
+		broadphase.clear();
+		leaves.clear();
+		local_bounds.clear();
+		proxies.clear();
+		added_entity_pairs.clear();
+		removed_entity_pairs.clear();
+
+		const u32 count{ reader.read<u32>() };
+		for (u32 i{ 0 }; i < count; ++i) {
+			const game_entity::entity entity{ game_entity::entity_id{ reader.read<id::id_type>() } };
+			bounds_info info;
+			reader.read((u8*)&info, sizeof(bounds_info));
+			add(entity, info);
+		}
+	}
+
+	void update() {
+		for (const transform::transform_id id : transform::changes()) {
+			// NOTE: transform ids are entity ids
+			const game_entity::entity_id entity_id{ (id::id_type)id };
+			if (!is_in_index(entity_id) || !game_entity::is_alive(entity_id)) continue;
+
+			const id::id_type index{ id::index(entity_id) };
+			const aabb bounds{ world_bounds(game_entity::entity{ entity_id }, local_bounds[index]) };
+			entity_tree.move(leaves[index], bounds);
+			if (proxies[index] != u32_invalid_id) broadphase.move(proxies[index], bounds);
+		}
+
+		broadphase.update();
+		added_entity_pairs.clear();
+		removed_entity_pairs.clear();
+		for (const overlap_pair& p : broadphase.added_pairs()) {
+			added_entity_pairs.emplace_back(entity_pair{ game_entity::entity_id{ p.a }, game_entity::entity_id{ p.b } });
+		}
+		for (const overlap_pair& p : broadphase.removed_pairs()) {
+			removed_entity_pairs.emplace_back(entity_pair{ game_entity::entity_id{ p.a }, game_entity::entity_id{ p.b } });
+		}
+
+		if (grid_enabled) agent_grid.build_from_transforms();
+	}
+
+	const utl::vector<entity_pair>& added_pairs() {
+		return added_entity_pairs;
+	}
+
+	const utl::vector<entity_pair>& removed_pairs() {
+		return removed_entity_pairs;
+	}
+
+	void enable_grid(f32 cell_size) {
+		agent_grid.set_cell_size(cell_size);
+		grid_enabled = true;
+	}
+
+	void disable_grid() {
+		grid_enabled = false;
+		agent_grid.build(nullptr, nullptr, 0);
+	}
+
+	const hash_grid& grid() {
+		return agent_grid;
+	}
+
+	bool raycast(const ray& r, ray_hit& hit) {
+		u32 user_data;
+		if (!entity_tree.raycast(r, user_data, hit.distance)) return false;
+		hit.id = game_entity::entity_id{ user_data };
+		return true;
+	}
+
+	void query(const aabb& box, utl::vector<game_entity::entity_id>& results) {
+		entity_tree.query(box, [&results](u32 user_data) { results.emplace_back(user_data); });
+	}
+
+	void query(const sphere& s, utl::vector<game_entity::entity_id>& results) {
+		entity_tree.query(s, [&results](u32 user_data) { results.emplace_back(user_data); });
+	}
+
+	void raycast(const ray* const rays, u32 count, ray_hit* const hits) {
+		assert(rays && hits);
+		jobs::parallel_for(count, query_range_size, [rays, hits](u32 first, u32 last) {
+			for (u32 i{ first }; i < last; ++i) {
+				if (!raycast(rays[i], hits[i])) hits[i] = {};
+			}
+			});
+	}
+
+	void query(const aabb* const boxes, u32 count, utl::vector<game_entity::entity_id>* const results) {
+		assert(boxes && results);
+		jobs::parallel_for(count, query_range_size, [boxes, results](u32 first, u32 last) {
+			for (u32 i{ first }; i < last; ++i) {
+				results[i].clear();
+				query(boxes[i], results[i]);
+			}
+			});
+	}
+
+	void query(const sphere* const spheres, u32 count, utl::vector<game_entity::entity_id>* const results) {
+		assert(spheres && results);
+		jobs::parallel_for(count, query_range_size, [spheres, results](u32 first, u32 last) {
+			for (u32 i{ first }; i < last; ++i) {
+				results[i].clear();
+				query(spheres[i], results[i]);
+			}
+			});
+	}
+}
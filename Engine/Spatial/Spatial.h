@@ -0,0 +1,65 @@
+#pragma once
+#include "SpatialCommon.h"
+#include "HashGrid.h"
+#include "..\Utilities\IOStream.h"
+
+namespace primal::spatial {
+
+	// Bounds of an entity in its local space. They're moved, rotated and scaled by the entity's transform.
+	struct bounds_info {
+		math::v3 center{};
+		math::v3 half_extents{ 0.5f, 0.5f, 0.5f };
+		// Report when the bounds of this entity start or stop overlapping those of other such entities
+		bool overlap_events{ false };
+	};
+
+	struct entity_pair {
+		game_entity::entity_id a{ id::invalid_id };
+		game_entity::entity_id b{ id::invalid_id };
+	};
+
+	struct ray_hit {
+		game_entity::entity_id id{ id::invalid_id };
+		f32 distance{ 0.f };
+	};
+
+	// Adds an entity to the spatial index. Entities are removed from the index when they're removed.
+	void add(game_entity::entity entity, bounds_info info);
+	// Does nothing if the entity isn't in the index
+	void remove(game_entity::entity_id id);
+	[[nodiscard]] bool contains(game_entity::entity_id id);
+
+	// Snapshots (see snapshot::save()). Only the entities and their bounds are saved. The tree and
+	// the broadphase are rebuilt when a snapshot is restored, so overlapping pairs are reported as added again.
+	[[nodiscard]] u64 snapshot_size();
+	void save_snapshot(utl::blob_stream_writer& writer);
+	void restore_snapshot(utl::blob_stream_reader& reader);
+
+	// Refits the bounds of entities whose transforms changed this frame, finds overlapping pairs
+	// and rebuilds the grid. Call after all transforms were set
+	// and before transform::clear_changes(). Queries see the state of the last call.
+	void update();
+
+	// Pairs of entities with overlap events whose bounds started or stopped overlapping in the last update().
+	// Pairs with removed entities are reported as removed, so check whether entities are alive.
+	[[nodiscard]] const utl::vector<entity_pair>& added_pairs();
+	[[nodiscard]] const utl::vector<entity_pair>& removed_pairs();
+
+	// Uniform grid over the positions of all transforms, for crowds of small agents.
+	// While it's enabled, it's rebuilt in update(). It's disabled by default.
+	void enable_grid(f32 cell_size);
+	void disable_grid();
+	[[nodiscard]] const hash_grid& grid();
+
+	// Single queries. Results are appended to 'results'.
+	bool raycast(const ray& r, ray_hit& hit);
+	void query(const aabb& box, utl::vector<game_entity::entity_id>& results);
+	void query(const sphere& s, utl::vector<game_entity::entity_id>& results);
+
+	// Batched queries, which are spread over the job system. Each query writes only its own result,
+	// e.g. results[i] is cleared and filled with the entities that overlap boxes[i].
+	// NOTE: don't add, remove or update entities while queries are running.
+	void raycast(const ray* const rays, u32 count, ray_hit* const hits);
+	void query(const aabb* const boxes, u32 count, utl::vector<game_entity::entity_id>* const results);
+	void query(const sphere* const spheres, u32 count, utl::vector<game_entity::entity_id>* const results);
+}
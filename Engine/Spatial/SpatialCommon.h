@@ -0,0 +1,94 @@
+#pragma once
+#include "..\Components\ComponentsCommon.h"
+
+#include <algorithm>
+
+namespace primal::spatial {
+
+	struct aabb {
+		math::v3 min{};
+		math::v3 max{};
+	};
+
+	struct sphere {
+		math::v3 center{};
+		f32 radius{ 0.f };
+	};
+
+	// Points on the ray are origin + t * direction, for t in [0, max_distance].
+	// NOTE: distances are in units of the direction's length, so use a normalized direction to get world units.
+	struct ray {
+		math::v3 origin{};
+		math::v3 direction{ 0.f, 0.f, 1.f };
+		f32 max_distance{ 1e30f };
+	};
+
+	[[nodiscard]] constexpr aabb merge(const aabb& a, const aabb& b) {
+		return {
+			{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+			{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) }
+		};
+	}
+
+	[[nodiscard]] constexpr bool overlaps(const aabb& a, const aabb& b) {
+		return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+			a.min.y <= b.max.y && a.max.y >= b.min.y &&
+			a.min.z <= b.max.z && a.max.z >= b.min.z;
+	}
+
+	[[nodiscard]] constexpr bool contains(const aabb& outer, const aabb& inner) {
+		return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+			outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+	}
+
+	[[nodiscard]] constexpr bool overlaps(const aabb& box, const sphere& s) {
+		f32 distance_sq{ 0.f };
+		const f32 c[3]{ s.center.x, s.center.y, s.center.z };
+		const f32 min[3]{ box.min.x, box.min.y, box.min.z };
+		const f32 max[3]{ box.max.x, box.max.y, box.max.z };
+		for (u32 i{ 0 }; i < 3; ++i) {
+			const f32 d{ c[i] < min[i] ? min[i] - c[i] : c[i] > max[i] ? c[i] - max[i] : 0.f };
+			distance_sq += d * d;
+		}
+		return distance_sq <= s.radius * s.radius;
+	}
+
+	// Half of the surface area, which is all the surface area heuristic (SAH) needs for comparisons
+	[[nodiscard]] constexpr f32 half_area(const aabb& box) {
+		const f32 dx{ box.max.x - box.min.x }, dy{ box.max.y - box.min.y }, dz{ box.max.z - box.min.z };
+		return dx * dy + dy * dz + dz * dx;
+	}
+
+	[[nodiscard]] constexpr aabb expand(const aabb& box, f32 margin) {
+		return {
+			{ box.min.x - margin, box.min.y - margin, box.min.z - margin },
+			{ box.max.x + margin, box.max.y + margin, box.max.z + margin }
+		};
+	}
+
+	// Slab test. Returns true if the ray hits the box within [0, max_distance]
+	// and sets 'distance' to where the ray enters the box (0 if the origin is inside).
+	[[nodiscard]] inline bool intersects(const ray& r, const aabb& box, f32 max_distance, f32& distance) {
+		const f32 o[3]{ r.origin.x, r.origin.y, r.origin.z };
+		const f32 d[3]{ r.direction.x, r.direction.y, r.direction.z };
+		const f32 min[3]{ box.min.x, box.min.y, box.min.z };
+		const f32 max[3]{ box.max.x, box.max.y, box.max.z };
+		f32 t_min{ 0.f }, t_max{ max_distance };
+		for (u32 i{ 0 }; i < 3; ++i) {
+			if (d[i] == 0.f) {
+				if (o[i] < min[i] || o[i] > max[i]) return false;
+				continue;
+			}
+
+			const f32 inv_d{ 1.f / d[i] };
+			f32 t0{ (min[i] - o[i]) * inv_d }, t1{ (max[i] - o[i]) * inv_d };
+			if (t0 > t1) std::swap(t0, t1);
+			t_min = std::max(t_min, t0);
+			t_max = std::min(t_max, t1);
+			if (t_min > t_max) return false;
+		}
+
+		distance = t_min;
+		return true;
+	}
+}
@@ -0,0 +1,133 @@
+#include "SweepAndPrune.h"
+
+namespace primal::spatial {
+
+	// anonymous namespace
+	namespace {
+		constexpr u32 freed_proxy{ u32_invalid_id - 1 };
+
+		constexpr overlap_pair to_pair(u64 key) {
+			return { (u32)(key >> 32), (u32)key };
+		}
+
+		bool overlaps_simd(const math::v4a& min_a, const math::v4a& max_a, const math::v4a& min_b, const math::v4a& max_b) {
+			using namespace DirectX;
+			return XMVector3LessOrEqual(XMLoadFloat4A(&min_a), XMLoadFloat4A(&max_b)) &&
+				XMVector3LessOrEqual(XMLoadFloat4A(&min_b), XMLoadFloat4A(&max_a));
+		}
+	} // anonymous namespace
+
+	u32 sweep_and_prune::add(const aabb& box, u32 user_data) {
+		assert(user_data < freed_proxy);
+		u32 index;
+		if (!_free_proxies.empty()) {
+			index = _free_proxies.back();
+			_free_proxies.pop_back();
+		}
+		else {
+			index = (u32)_proxies.size();
+			_proxies.emplace_back();
+		}
+
+		_proxies[index].user_data = user_data;
+		move(index, box);
+		_added_proxies.emplace_back(index);
+		return index;
+	}
+
+	void sweep_and_prune::remove(u32 proxy) {
+		assert(proxy < _proxies.size() && _proxies[proxy].user_data < freed_proxy);
+		// NOTE: the proxy can't be reused before update() took it out of the sorted list
+		_proxies[proxy].user_data = freed_proxy;
+		_removed_proxies.emplace_back(proxy);
+	}
+
+	void sweep_and_prune::move(u32 proxy, const aabb& box) {
+		assert(proxy < _proxies.size());
+		proxy_box& p{ _proxies[proxy] };
+		p.min = { box.min.x, box.min.y, box.min.z, 0.f };
+		p.max = { box.max.x, box.max.y, box.max.z, 0.f };
+	}
+
+	void sweep_and_prune::clear() {
+		_proxies.clear();
+		_sorted.clear();
+		_added_proxies.clear();
+		_removed_proxies.clear();
+		_free_proxies.clear();
+		_pairs.clear();
+		_added_pairs.clear();
+		_removed_pairs.clear();
+	}
+
+	void sweep_and_prune::update() {
+		// drop removed proxies, refresh the x extents and append the new proxies
+		u32 count{ 0 };
+		for (u32 i{ 0 }; i < _sorted.size(); ++i) {
+			const proxy_box& p{ _proxies[_sorted[i].proxy] };
+			if (p.user_data == freed_proxy) continue;
+			_sorted[count++] = { p.min.x, p.max.x, _sorted[i].proxy };
+		}
+		_sorted.resize(count);
+
+		for (const u32 index : _removed_proxies) {
+			_proxies[index].user_data = u32_invalid_id;
+			_free_proxies.emplace_back(index);
+		}
+		_removed_proxies.clear();
+
+		for (const u32 index : _added_proxies) {
+			const proxy_box& p{ _proxies[index] };
+			if (p.user_data >= freed_proxy) continue; // removed again before this update
+			_sorted.emplace_back(endpoint{ p.min.x, p.max.x, index });
+		}
+		_added_proxies.clear();
+
+		// insertion sort, which is fast when the order barely changed since the last frame
+		for (u32 i{ 1 }; i < _sorted.size(); ++i) {
+			const endpoint e{ _sorted[i] };
+			u32 j{ i };
+			while (j > 0 && _sorted[j - 1].min_x > e.min_x) {
+				_sorted[j] = _sorted[j - 1];
+				--j;
+			}
+			_sorted[j] = e;
+		}
+
+		// sweep: only boxes that start before the current box ends can overlap it on x
+		_new_pairs.clear();
+		const u32 sorted_count{ (u32)_sorted.size() };
+		for (u32 i{ 0 }; i < sorted_count; ++i) {
+			const endpoint& e{ _sorted[i] };
+			const proxy_box& a{ _proxies[e.proxy] };
+			for (u32 j{ i + 1 }; j < sorted_count && _sorted[j].min_x <= e.max_x; ++j) {
+				const proxy_box& b{ _proxies[_sorted[j].proxy] };
+				if (!overlaps_simd(a.min, a.max, b.min, b.max)) continue;
+
+				const u32 lo{ std::min(a.user_data, b.user_data) };
+				const u32 hi{ std::max(a.user_data, b.user_data) };
+				_new_pairs.emplace_back(((u64)lo << 32) | hi);
+			}
+		}
+		std::sort(_new_pairs.begin(), _new_pairs.end());
+
+		// the difference of the old and the new sorted pairs are the added and removed pairs
+		_added_pairs.clear();
+		_removed_pairs.clear();
+		u32 i{ 0 }, j{ 0 };
+		while (i < _pairs.size() || j < _new_pairs.size()) {
+			if (j == _new_pairs.size() || (i < _pairs.size() && _pairs[i] < _new_pairs[j])) {
+				_removed_pairs.emplace_back(to_pair(_pairs[i++]));
+			}
+			else if (i == _pairs.size() || _new_pairs[j] < _pairs[i]) {
+				_added_pairs.emplace_back(to_pair(_new_pairs[j++]));
+			}
+			else {
+				++i;
+				++j;
+			}
+		}
+
+		_pairs.swap(_new_pairs);
+	}
+}
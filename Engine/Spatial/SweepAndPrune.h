@@ -0,0 +1,57 @@
+#pragma once
+#include "SpatialCommon.h"
+
+namespace primal::spatial {
+
+	struct overlap_pair {
+		u32 a;	// user data of the two proxies, a < b
+		u32 b;
+	};
+
+	// Broadphase that finds the pairs of boxes that overlap. Boxes are kept sorted by their minimum x, using
+	// insertion sort, which is close to linear when boxes only move a little from frame to frame. The sorted
+	// list is swept to find the candidates that overlap on x, which are then tested on all axes with SIMD.
+	// Each call to update() reports which pairs started and which stopped overlapping since the last call.
+	class sweep_and_prune {
+	public:
+		// Adds a box and returns its proxy
+		u32 add(const aabb& box, u32 user_data);
+		// NOTE: pairs of removed proxies are reported as removed by the next update()
+		void remove(u32 proxy);
+		void move(u32 proxy, const aabb& box);
+		// Removes all proxies. Their pairs aren't reported as removed.
+		void clear();
+
+		void update();
+
+		[[nodiscard]] const utl::vector<overlap_pair>& added_pairs() const { return _added_pairs; }
+		[[nodiscard]] const utl::vector<overlap_pair>& removed_pairs() const { return _removed_pairs; }
+		// All pairs that overlapped in the last update(), sorted by a and b
+		[[nodiscard]] const utl::vector<u64>& pairs() const { return _pairs; }
+
+	private:
+		struct proxy_box {
+			math::v4a min;
+			math::v4a max;
+			u32 user_data{ u32_invalid_id };
+		};
+
+		struct endpoint {
+			f32 min_x;
+			f32 max_x;
+			u32 proxy;
+		};
+
+		utl::vector<proxy_box> _proxies;
+		utl::vector<endpoint> _sorted;		// sorted by min_x
+		utl::vector<u32> _added_proxies;	// not in _sorted yet
+		utl::vector<u32> _removed_proxies;	// still in _sorted
+		utl::vector<u32> _free_proxies;
+
+		// NOTE: pairs are stored as (a << 32) | b, so sorted pairs can be compared with a merge
+		utl::vector<u64> _pairs;
+		utl::vector<u64> _new_pairs;
+		utl::vector<overlap_pair> _added_pairs;
+		utl::vector<overlap_pair> _removed_pairs;
+	};
+}
@@ -28,6 +28,14 @@ namespace primal::utl {
 			_position += length;
 		}
 
+		// reads a vector of trivially copyable items that was written with blob_stream_writer::write_vector()
+		template<typename T, bool destruct> void read_vector(vector<T, destruct>& v) {
+			static_assert(std::is_trivially_copyable_v<T>, "Template argument should be trivially copyable.");
+			const u32 count{ read<u32>() };
+			v.resize(count);
+			read((u8*)v.data(), count * sizeof(T));
+		}
+
 		void skip(size_t offset) {
 			_position += offset;
 		}
@@ -74,6 +82,13 @@ namespace primal::utl {
 			_position += length;
 		}
 
+		// writes the number of items in 'v' followed by the items
+		template<typename T, bool destruct> void write_vector(const vector<T, destruct>& v) {
+			static_assert(std::is_trivially_copyable_v<T>, "Template argument should be trivially copyable.");
+			write((u32)v.size());
+			write((const u8*)v.data(), v.size() * sizeof(T));
+		}
+
 		void skip(size_t offset) {
 			assert(&_position[offset] <= &_buffer[_buffer_size]);
 			_position += offset;
@@ -89,4 +104,9 @@ namespace primal::utl {
 		u8* _position;
 		size_t _buffer_size;
 	};
+
+	// Number of bytes that blob_stream_writer::write_vector() writes for 'v'
+	template<typename T, bool destruct> [[nodiscard]] constexpr u64 vector_blob_size(const vector<T, destruct>& v) {
+		return sizeof(u32) + v.size() * sizeof(T);
+	}
 }
\ No newline at end of file
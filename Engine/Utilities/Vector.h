@@ -86,6 +86,13 @@ namespace primal::utl {
 			return *item;
 		}
 
+		// Removes the last item
+		constexpr void pop_back() {
+			assert(_size);
+			if constexpr (destruct) _data[_size - 1].~T();
+			--_size;
+		}
+
 		// Resizes the vector and initializes new items with their default value
 		constexpr void resize(u64 new_size) {
 			static_assert(std::is_default_constructible<T>::value, "Type must be default-constructible.");
@@ -142,6 +149,22 @@ namespace primal::utl {
 			}
 		}
 
+		// Frees the memory that isn't used by any items
+		constexpr void shrink_to_fit() {
+			if (_capacity == _size) return;
+			if (!_size) {
+				destroy();
+				return;
+			}
+
+			void* new_buffer{ realloc(_data, _size * sizeof(T)) };
+			assert(new_buffer);
+			if (new_buffer) {
+				_data = static_cast<T*>(new_buffer);
+				_capacity = _size;
+			}
+		}
+
 		// Removes the item at specified index
 		constexpr T* const erase(u64 index) {
 			assert(_data && index < _size);
@@ -4,6 +4,7 @@
 #include "..\Engine\Components\Entity.h"
 #include "..\Engine\Components\Transform.h"
 #include "..\Engine\Components\Script.h"
+#include "..\Engine\Components\ChangeJournal.h"
 
 using namespace primal;
 
@@ -78,3 +79,32 @@ EDITOR_INTERFACE void RemoveGameEntity(id::id_type id)
 	assert(id::is_valid(id));
 	game_entity::remove(game_entity::entity_id {id });
 }
+
+EDITOR_INTERFACE void EnableChangeJournal(u32 capacity)
+{
+	journal::enable(capacity);
+}
+
+// Records the transform changes since the last call and starts a new frame in the journal.
+// The editor doesn't run the game loop, so a caller that reads the journal should call this once per frame before reading it.
+// NOTE: the editor doesn't use the journal yet.
+EDITOR_INTERFACE void EndChangeJournalFrame()
+{
+	journal::end_frame();
+}
+
+EDITOR_INTERFACE u64 GetChangeJournalCursor()
+{
+	return journal::end_cursor();
+}
+
+// Returns the number of records written to 'records'. 'overrun' is set to 1 if records
+// since 'cursor' were lost, in which case the editor should resynchronize all entities.
+EDITOR_INTERFACE u32 ReadChangeJournal(u64* cursor, journal::change_record* records, u32 max_count, u32* overrun)
+{
+	assert(cursor && records && overrun);
+	bool lost{ false };
+	const u32 count{ journal::read(*cursor, records, max_count, lost) };
+	*overrun = lost ? 1 : 0;
+	return count;
+}
@@ -11,6 +11,12 @@
 #elif TEST_RENDERER
 	#include "TestRenderer.h"
 
+#elif TEST_ENTITY_BENCHMARK
+	#include "TestEntityBenchmark.h"
+
+#elif TEST_ENGINE_REGRESSIONS
+	#include "TestEngineRegressions.h"
+
 #else
 	#error One of the tests need to be enabled
 
@@ -73,7 +79,7 @@ int WINAPI WinMain(_In_ HINSTANCE, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ int)
 // ENTITY COMPONENT TESTING
 int main() {
 
-#if _DEBUG
+#if _DEBUG && defined(_MSC_VER)
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
@@ -6,6 +6,8 @@
 #define TEST_ENTITY_COMPONENTS 0
 #define TEST_WINDOW 0
 #define TEST_RENDERER 1
+#define TEST_ENTITY_BENCHMARK 0
+#define TEST_ENGINE_REGRESSIONS 0
 
 class test
 {
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "Test.h"
+#include "..\Engine\Core\JobSystem.h"
+#include "..\Engine\Components\Entity.h"
+#include "..\Engine\Components\Transform.h"
+#include "..\Engine\Components\Script.h"
+#include "..\Engine\Components\ChangeJournal.h"
+#include "..\Engine\Components\EntityCommands.h"
+#include "..\Engine\Components\Snapshot.h"
+
+#include <atomic>
+#include <cstdio>
+
+using namespace primal;
+
+// Headless checks for engine bugs that were fixed. Every case prints whether it passed,
+// and run() prints the number of failed cases at the end.
+
+class counting_script : public script::entity_script
+{
+public:
+	constexpr explicit counting_script(game_entity::entity entity) : script::entity_script{ entity } {}
+
+	void update(float) override
+	{
+		++update_count;
+	}
+
+	static inline u32 update_count{ 0 };
+};
+
+REGISTER_SCRIPT(counting_script);
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		return jobs::initialize(3);
+	}
+
+	void run() override
+	{
+		check("nested parallel_for", nested_parallel_for());
+		check("sleep and wake in the same frame", sleep_and_wake_in_same_frame());
+		check("change journal without the game loop", change_journal_without_game_loop());
+		check("snapshot with an unknown script type", snapshot_with_unknown_script_type());
+
+		printf("%u of %u checks failed\n", _failed, _count);
+
+#ifdef _WIN64
+		// NOTE: the checks run once, so the message loop in WinMain() stops after them
+		PostQuitMessage(0);
+#endif // _WIN64
+	}
+
+	void shutdown() override
+	{
+		jobs::shutdown();
+	}
+
+private:
+	void check(const char* name, bool passed)
+	{
+		printf("%-40s %s\n", name, passed ? "passed" : "FAILED");
+		++_count;
+		if (!passed) ++_failed;
+	}
+
+	// parallel_for() called from inside a range used to deadlock on the worker threads
+	bool nested_parallel_for()
+	{
+		constexpr u32 outer_count{ 64 };
+		constexpr u32 inner_count{ 1000 };
+		std::atomic<u32> sum{ 0 };
+		jobs::parallel_for(outer_count, 1, [&](u32 first, u32 last) {
+			for (u32 i{ first }; i < last; ++i)
+			{
+				jobs::parallel_for(inner_count, 16, [&](u32 inner_first, u32 inner_last) {
+					sum += inner_last - inner_first;
+					});
+			}
+			});
+
+		return sum == outer_count * inner_count;
+	}
+
+	// a wake request was dropped if the same script also asked to sleep in the same frame
+	bool sleep_and_wake_in_same_frame()
+	{
+		transform::init_info transform_info{ {}, { 0.f, 0.f, 0.f, 1.f } };
+		script::init_info script_info{ script::detail::get_script_creator(script::detail::string_hash()("counting_script")) };
+		game_entity::entity entity{ game_entity::create({ &transform_info, &script_info }) };
+		script::component script{ entity.script() };
+		bool passed{ true };
+
+		// the last request wins
+		counting_script::update_count = 0;
+		script.sleep();
+		script.wake();
+		script::update(1.f);
+		passed &= counting_script::update_count == 1;
+
+		script.wake();
+		script.sleep();
+		script::update(1.f);
+		passed &= counting_script::update_count == 1;
+
+		// a sleeping script that is put to sleep again and woken up in the same frame
+		script.sleep();
+		script.wake();
+		script::update(1.f);
+		passed &= counting_script::update_count == 2;
+
+		game_entity::remove(entity.get_id());
+		return passed;
+	}
+
+	// transform changes were only journaled by the game loop, so the editor never got them
+	bool change_journal_without_game_loop()
+	{
+		journal::enable(64);
+		transform::init_info transform_info{ {}, { 0.f, 0.f, 0.f, 1.f } };
+		game_entity::entity entity{ game_entity::create({ &transform_info }) };
+		journal::end_frame();
+
+		entity.transform().set_position({ 1.f, 2.f, 3.f });
+		journal::end_frame();
+
+		u64 cursor{ 0 };
+		journal::change_record records[8];
+		bool overrun{ false };
+		const u32 count{ journal::read(cursor, &records[0], _countof(records), overrun) };
+
+		bool passed{ !overrun && count == 3 };
+		if (passed)
+		{
+			const u32 first_frame{ records[0].frame };
+			passed &= records[0].type == journal::change_type::created && records[0].entity == entity.get_id();
+			passed &= records[1].type == journal::change_type::transform_changed && records[1].frame == first_frame;
+			passed &= records[2].type == journal::change_type::transform_changed && records[2].frame == first_frame + 1 &&
+				(records[2].flags & transform::change_flags::position) != 0;
+		}
+
+		game_entity::remove(entity.get_id());
+		journal::disable();
+		return passed;
+	}
+
+	// restoring a snapshot with a script type that isn't registered changed the world before it failed
+	bool snapshot_with_unknown_script_type()
+	{
+		transform::init_info transform_info{ {}, { 0.f, 0.f, 0.f, 1.f } };
+		script::init_info script_info{ script::detail::get_script_creator(script::detail::string_hash()("counting_script")) };
+		game_entity::entity entity{ game_entity::create({ &transform_info, &script_info }) };
+
+		utl::vector<u8> image;
+		snapshot::save(image);
+		bool passed{ snapshot::restore(image.data(), image.size()) && game_entity::is_alive(entity.get_id()) };
+
+		// replace the tag of the script type with one that isn't registered
+		const u64 tag{ (u64)script::detail::string_hash()("counting_script") };
+		u32 replaced{ 0 };
+		for (u64 i{ 0 }; i + sizeof(u64) <= image.size(); ++i)
+		{
+			u64 value;
+			memcpy(&value, &image[i], sizeof(u64));
+			if (value != tag) continue;
+			value = ~tag;
+			memcpy(&image[i], &value, sizeof(u64));
+			++replaced;
+		}
+		passed &= replaced == 1;
+
+		const game_entity::entity other{ game_entity::create({ &transform_info }) };
+		game_entity::commands().remove(entity.get_id());
+		passed &= !snapshot::restore(image.data(), image.size());
+		passed &= game_entity::is_alive(other.get_id()) && game_entity::is_alive(entity.get_id()) && entity.script().is_valid();
+
+		// commands that were recorded before a successful restore are dropped
+		snapshot::save(image);
+		passed &= snapshot::restore(image.data(), image.size());
+		game_entity::flush_commands();
+		passed &= game_entity::is_alive(entity.get_id());
+
+		// a damaged image is rejected
+		passed &= !snapshot::restore(image.data(), image.size() - 1);
+
+		game_entity::remove(other.get_id());
+		game_entity::remove(entity.get_id());
+		return passed;
+	}
+
+	u32 _count{ 0 };
+	u32 _failed{ 0 };
+};
\ No newline at end of file
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "Test.h"
+#include "..\Engine\Components\Entity.h"
+#include "..\Engine\Components\Transform.h"
+#include "..\Engine\Components\Script.h"
+#include "..\Engine\Components\Query.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace primal;
+
+// Headless benchmarks of the entity/component layer. Every case runs a few warmup repetitions that
+// aren't measured, followed by the measured ones. Setup and cleanup of each repetition aren't timed.
+// The results are printed and written to entity_benchmark.json, so they can be compared across engine versions.
+// NOTE: the benchmarks are built with the EngineTest project and link engine.lib, so they only run on Windows.
+//		 The engine's math types and components use DirectXMath, and there is no build for other platforms.
+
+class benchmark_script : public script::entity_script
+{
+public:
+	constexpr explicit benchmark_script(game_entity::entity entity) : script::entity_script{ entity } {}
+
+	void update(float dt) override
+	{
+		_time += dt;
+	}
+
+private:
+	float _time{ 0.f };
+};
+
+REGISTER_SCRIPT(benchmark_script);
+
+class engine_test : public test
+{
+public:
+	bool initialize() override
+	{
+		_script_info.script_creator = script::detail::get_script_creator(script::detail::string_hash()("benchmark_script"));
+		return _script_info.script_creator != nullptr;
+	}
+
+	void run() override
+	{
+		for (const benchmark_size& size : _sizes)
+		{
+			run_cases(size);
+		}
+
+		print_results();
+		write_json("entity_benchmark.json");
+
+#ifdef _WIN64
+		// NOTE: the benchmarks run once, so the message loop in WinMain() stops after them
+		PostQuitMessage(0);
+#endif // _WIN64
+	}
+
+	void shutdown() override { }
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	struct benchmark_size
+	{
+		u32 entity_count;
+		u32 repetitions;
+	};
+
+	struct result
+	{
+		const char* name;
+		u32 entity_count;
+		u32 repetitions;
+		double median_ms;
+		double p99_ms;
+		double min_ms;
+		double mean_ms;
+	};
+
+	static constexpr u32 warmup_repetitions{ 2 };
+	// NOTE: fewer repetitions for more entities, so that every size takes about the same time
+	static constexpr benchmark_size _sizes[]{ { 1'000, 200 }, { 100'000, 20 }, { 1'000'000, 5 } };
+
+	void run_cases(const benchmark_size& size)
+	{
+		const u32 count{ size.entity_count };
+		game_entity::entity_info info{ &_transform_info };
+		game_entity::entity_info script_info{ &_transform_info, &_script_info };
+		_ids.resize(count);
+
+		measure("create", size,
+			[] {},
+			[&] { for (u32 i{ 0 }; i < count; ++i) _ids[i] = game_entity::create(info).get_id(); },
+			[&] { remove_all(); });
+
+		measure("create_many", size,
+			[] {},
+			[&] { game_entity::create_many(info, nullptr, count, _ids.data()); },
+			[&] { remove_all(); });
+
+		measure("remove", size,
+			[&] { create_shuffled(info); },
+			[&] { for (const game_entity::entity_id id : _ids) game_entity::remove(id); },
+			[&] { compact(); });
+
+		measure("remove_many", size,
+			[&] { create_shuffled(info); },
+			[&] { game_entity::remove_many(_ids.data(), count); },
+			[&] { compact(); });
+
+		// removes and creates 10% of the entities, 10 times
+		measure("churn", size,
+			[&] { create_shuffled(info); },
+			[&] {
+				const u32 churn_count{ std::max(count / 10, 1u) };
+				for (u32 round{ 0 }; round < 10; ++round)
+				{
+					const u32 first{ (round * churn_count) % (count - churn_count + 1) };
+					for (u32 i{ first }; i < first + churn_count; ++i) game_entity::remove(_ids[i]);
+					for (u32 i{ first }; i < first + churn_count; ++i) _ids[i] = game_entity::create(info).get_id();
+				}
+			},
+			[&] { remove_all(); });
+
+		// the following cases use the same entities for all repetitions
+		game_entity::create_many(script_info, nullptr, count, _ids.data());
+		transform::clear_changes();
+
+		measure("iterate", size,
+			[] {},
+			[&] {
+				u64 sum{ 0 };
+				game_entity::for_each<transform::component>([&](game_entity::entity e, transform::component t) {
+					sum += (u64)e.get_id() + (u64)t.get_id();
+					});
+				_sink = sum;
+			},
+			[] {});
+
+		measure("transform_access", size,
+			[] {},
+			[&] {
+				for (const game_entity::entity_id id : _ids)
+				{
+					transform::component t{ game_entity::entity{ id }.transform() };
+					math::v3 position{ t.position() };
+					position.x += 1.f;
+					t.set_position(position);
+				}
+			},
+			[] { transform::clear_changes(); });
+
+		measure("script_update", size,
+			[] {},
+			[] { script::update(16.f); },
+			[] { transform::clear_changes(); });
+
+		remove_all();
+	}
+
+	template<typename Setup, typename Body, typename Cleanup>
+	void measure(const char* name, const benchmark_size& size, Setup setup, Body body, Cleanup cleanup)
+	{
+		utl::vector<double> times;
+		times.reserve(size.repetitions);
+		for (u32 i{ 0 }; i < warmup_repetitions + size.repetitions; ++i)
+		{
+			setup();
+			const clock::time_point start{ clock::now() };
+			body();
+			const double ms{ std::chrono::duration<double, std::milli>(clock::now() - start).count() };
+			cleanup();
+			if (i >= warmup_repetitions) times.emplace_back(ms);
+		}
+
+		std::sort(times.begin(), times.end());
+		const size_t n{ times.size() };
+		result r{ name, size.entity_count, size.repetitions };
+		r.median_ms = (n % 2) ? times[n / 2] : 0.5 * (times[n / 2 - 1] + times[n / 2]);
+		// NOTE: nearest-rank percentile. With less than 100 repetitions, this is the slowest one.
+		r.p99_ms = times[std::min(n - 1, (size_t)std::ceil(0.99 * n) - 1)];
+		r.min_ms = times.front();
+		double sum{ 0.0 };
+		for (const double t : times) sum += t;
+		r.mean_ms = sum / n;
+		_results.emplace_back(r);
+	}
+
+	void create_shuffled(const game_entity::entity_info& info)
+	{
+		game_entity::create_many(info, nullptr, (u32)_ids.size(), _ids.data());
+		transform::clear_changes();
+		std::shuffle(_ids.begin(), _ids.end(), _random);
+	}
+
+	void remove_all()
+	{
+		game_entity::remove_many(_ids.data(), (u32)_ids.size());
+		compact();
+	}
+
+	// NOTE: removed transforms are compacted by a scheduler task, which doesn't run here
+	void compact()
+	{
+		transform::compact(u32_invalid_id);
+		transform::clear_changes();
+	}
+
+	void print_results()
+	{
+		printf("%-18s %10s %12s %12s %12s %14s\n", "case", "entities", "median (ms)", "p99 (ms)", "min (ms)", "ns per entity");
+		for (const result& r : _results)
+		{
+			printf("%-18s %10u %12.3f %12.3f %12.3f %14.1f\n", r.name, r.entity_count, r.median_ms, r.p99_ms, r.min_ms,
+				r.median_ms * 1e6 / r.entity_count);
+		}
+	}
+
+	void write_json(const char* path)
+	{
+		FILE* file{ fopen(path, "w") };
+		if (!file) return;
+
+		fprintf(file, "{\n  \"benchmark\": \"entity_components\",\n  \"warmup_repetitions\": %u,\n  \"results\": [\n", warmup_repetitions);
+		for (size_t i{ 0 }; i < _results.size(); ++i)
+		{
+			const result& r{ _results[i] };
+			fprintf(file, "    { \"name\": \"%s\", \"entities\": %u, \"repetitions\": %u, \"median_ms\": %.6f, \"p99_ms\": %.6f, "
+				"\"min_ms\": %.6f, \"mean_ms\": %.6f, \"median_ns_per_entity\": %.3f }%s\n",
+				r.name, r.entity_count, r.repetitions, r.median_ms, r.p99_ms, r.min_ms, r.mean_ms,
+				r.median_ms * 1e6 / r.entity_count, i + 1 < _results.size() ? "," : "");
+		}
+		fprintf(file, "  ]\n}\n");
+		fclose(file);
+	}
+
+	transform::init_info _transform_info{ {}, { 0.f, 0.f, 0.f, 1.f } };
+	script::init_info _script_info{};
+	utl::vector<game_entity::entity_id> _ids;
+	utl::vector<result> _results;
+	std::mt19937 _random{ 12345 };
+	volatile u64 _sink{ 0 };
+};
\ No newline at end of file
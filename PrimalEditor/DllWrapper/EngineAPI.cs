@@ -28,6 +28,23 @@ namespace PrimalEditor.EngineAPIStructs
         public TransformComponent Transform = new TransformComponent();
         public ScriptComponent Script = new ScriptComponent();
     }
+
+    enum ChangeType : uint
+    {
+        Created,
+        Removed,
+        TransformChanged,
+        Reset,
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    struct ChangeRecord
+    {
+        public uint Frame;
+        public ChangeType Type;
+        public int EntityId;
+        public uint Flags;
+    }
 }
 
 
@@ -105,6 +122,29 @@ namespace PrimalEditor.DllWrapper
             {
                 RemoveGameEntity(entity.EntityId);
             }
+
+            // The change journal lets the editor pull what changed in the engine since its last read.
+            // NOTE: nothing in the editor enables or reads it yet.
+            [DllImport(_engineDLL)]
+            public static extern void EnableChangeJournal(uint capacity);
+
+            // Must be called once per editor frame, before reading the journal, so that transform changes are recorded
+            [DllImport(_engineDLL)]
+            public static extern void EndChangeJournalFrame();
+
+            [DllImport(_engineDLL)]
+            public static extern ulong GetChangeJournalCursor();
+
+            [DllImport(_engineDLL)]
+            private static extern uint ReadChangeJournal(ref ulong cursor, [Out] ChangeRecord[] records, uint maxCount, out uint overrun);
+            // Returns the number of records read into 'records'. When 'overrun' is true, records were lost
+            // and all entities should be resynchronized.
+            public static int ReadChangeJournal(ref ulong cursor, ChangeRecord[] records, out bool overrun)
+            {
+                var count = ReadChangeJournal(ref cursor, records, (uint)records.Length, out uint lost);
+                overrun = lost != 0;
+                return (int)count;
+            }
         }
     }
 }
@@ -2,6 +2,7 @@
 using System.Diagnostics;
 using System.IO;
 using System.Runtime.Serialization;
+using System.Text;
 using System.Windows;
 using System.Windows.Input;
 
@@ -191,24 +192,129 @@ namespace PrimalEditor.GameProject
 			Logger.Log(MessageType.Info, $"Project saved to {project.FullPath}");
 		}
 
+		// Entities are grouped into square cells on the xz plane, so the engine can stream them in and out
+		// around the camera. Each cell is stored as one block of entities, which the engine loads with one read.
+		private const float WorldCellSize = 64.0f;
+
+		private static void WriteEntity(BinaryWriter bw, GameEntity entity)
+		{
+			bw.Write(0); // entity type: 0 for entities that aren't prefab instances
+			bw.Write(entity.Components.Count);
+
+			foreach (var component in entity.Components)
+			{
+				bw.Write((int)component.ToEnumType());
+				component.WriteToBinary(bw);
+			}
+		}
+
+		// Entities whose components, except for the transform, write the same bytes share a prefab
+		private static string GetPrefabKey(GameEntity entity)
+		{
+			using var stream = new MemoryStream();
+			using (var bw = new BinaryWriter(stream))
+			{
+				foreach (var component in entity.Components.Where(x => x is not Transform))
+				{
+					bw.Write((int)component.ToEnumType());
+					component.WriteToBinary(bw);
+				}
+			}
+			return Convert.ToBase64String(stream.ToArray());
+		}
+
+		private static byte[] WriteEntities(IEnumerable<GameEntity> entities, Dictionary<GameEntity, int> entityPrefabs)
+		{
+			using var stream = new MemoryStream();
+			using (var bw = new BinaryWriter(stream))
+			{
+				// NOTE: instances of the same prefab are written next to each other, so the engine can create them in one batch
+				var orderedEntities = entities.OrderBy(x => entityPrefabs.GetValueOrDefault(x, -1)).ToList();
+				foreach (var entity in orderedEntities)
+				{
+					if (entityPrefabs.TryGetValue(entity, out var prefab))
+					{
+						// instances only store their prefab and their transform
+						bw.Write(prefab + 1);
+						entity.GetComponent<Transform>().WriteToBinary(bw);
+					}
+					else
+					{
+						WriteEntity(bw, entity);
+					}
+				}
+
+				// names, which refer to entities by their position in the block
+				var namedEntities = orderedEntities.Select((entity, index) => (entity, index)).Where(x => !string.IsNullOrEmpty(x.entity.Name)).ToList();
+				bw.Write(namedEntities.Count);
+				foreach (var (entity, index) in namedEntities)
+				{
+					var nameBytes = Encoding.UTF8.GetBytes(entity.Name);
+					bw.Write(index);
+					bw.Write(nameBytes.Length);
+					bw.Write(nameBytes);
+				}
+			}
+			return stream.ToArray();
+		}
+
 		private void SaveToBinary()
 		{
 			var configName = VisualStudio.GetConfigurationName(StandAloneBuildConfig);
 			var bin = $@"{Path}x64\{configName}\game.bin";
 
-			using (var bw = new BinaryWriter(File.Open(bin, FileMode.Create, FileAccess.Write)))
+			var prefabs = new List<GameEntity>();
+			var entityPrefabs = new Dictionary<GameEntity, int>();
+			foreach (var group in ActiveScene.GameEntities.GroupBy(x => GetPrefabKey(x)).Where(x => x.Count() > 1))
 			{
-				bw.Write(ActiveScene.GameEntities.Count);
-				foreach (var entity in ActiveScene.GameEntities)
+				foreach (var entity in group)
 				{
-					bw.Write(0); // entity type (reserved for later)
-					bw.Write(entity.Components.Count);
+					entityPrefabs[entity] = prefabs.Count;
+				}
+				prefabs.Add(group.First());
+			}
 
-					foreach (var component in entity.Components)
+			var cells = ActiveScene.GameEntities
+				.GroupBy(x =>
+				{
+					var position = x.GetComponent<Transform>().Position;
+					return (X: (int)MathF.Floor(position.X / WorldCellSize), Z: (int)MathF.Floor(position.Z / WorldCellSize));
+				})
+				.ToList();
+			var blocks = cells.Select(cell => WriteEntities(cell, entityPrefabs)).ToList();
+
+			using (var bw = new BinaryWriter(File.Open(bin, FileMode.Create, FileAccess.Write)))
+			{
+				// prefabs, written as complete entities
+				using (var stream = new MemoryStream())
+				{
+					using (var prefabWriter = new BinaryWriter(stream))
 					{
-						bw.Write((int)component.ToEnumType());
-						component.WriteToBinary(bw);
+						prefabs.ForEach(x => WriteEntity(prefabWriter, x));
 					}
+					var prefabBlock = stream.ToArray();
+					bw.Write(prefabs.Count);
+					bw.Write(prefabBlock.Length);
+					bw.Write(prefabBlock);
+				}
+
+				// cell table, followed by the blocks
+				bw.Write(WorldCellSize);
+				bw.Write(cells.Count);
+				long offset = 0;
+				for (int i = 0; i < cells.Count; ++i)
+				{
+					bw.Write(cells[i].Key.X);
+					bw.Write(cells[i].Key.Z);
+					bw.Write(cells[i].Count());
+					bw.Write(offset); // from the first block
+					bw.Write(blocks[i].Length);
+					offset += blocks[i].Length;
+				}
+
+				foreach (var block in blocks)
+				{
+					bw.Write(block);
 				}
 			}
 		}